@@ -0,0 +1,87 @@
+/**
+ * @file
+ * @brief nanoForth mock Arduino Stream implementation (host only)
+ */
+#include "mockio.h"
+#if !ARDUINO
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cstring>
+
+FileStream Serial;                     ///< console, on stdin/stdout
+
+FileStream::~FileStream() {
+    if (_pp) pclose(_pp);
+}
+int FileStream::open(const char *fname) {
+    int fd = ::open(fname, O_RDONLY);
+    if (fd < 0) return 0;
+    _fd  = fd;
+    _hd  = _tl = _eof = 0;
+    return 1;
+}
+int FileStream::pipe(const char *cmd) {
+    FILE *pp = popen(cmd, "r");
+    if (!pp) return 0;
+    _pp  = pp;
+    _fd  = fileno(pp);
+    _hd  = _tl = _eof = 0;
+    return 1;
+}
+///
+///> refill input buffer with whatever the descriptor has (one system call)
+///
+int FileStream::_fill(int wait) {
+    if (_hd < _tl) return _tl - _hd;
+    if (_eof) return 0;
+    if (!wait) {
+        struct pollfd pf = { _fd, POLLIN, 0 };
+        if (poll(&pf, 1, 0) <= 0) return 0;    /// * nothing arrived yet
+    }
+    int n = ::read(_fd, _buf, sizeof(_buf));
+    if (n <= 0) { _eof = 1; return 0; }
+    _hd = 0;
+    _tl = n;
+    return n;
+}
+int FileStream::available() { return _fill(0); }
+int FileStream::read() {
+    return _fill(1) ? _buf[_hd++] : -1;
+}
+int FileStream::read_line(char *buf, int max, int *eol) {
+    int n = 0;
+    *eol = 0;
+    while (n < max && _fill(0)) {
+        uint8_t *p0 = &_buf[_hd];
+        int     sz  = _tl - _hd < max - n ? _tl - _hd : max - n;
+        uint8_t *p1 = (uint8_t*)memchr(p0, '\n', sz);
+        uint8_t *p2 = (uint8_t*)memchr(p0, '\r', sz);
+        if (p2 && (!p1 || p2 < p1)) p1 = p2;
+        int m = p1 ? (int)(p1 - p0) : sz;
+        memcpy(buf + n, p0, m);                /// * copy a block, not char-by-char
+        n   += m;
+        _hd += m + (p1 ? 1 : 0);
+        if (p1) { *eol = 1; break; }
+    }
+    return n;
+}
+
+int MemStream::read() {
+    if (_p < _end) return (uint8_t)*_p++;
+    _eof = 1;
+    return -1;
+}
+int MemStream::read_line(char *buf, int max, int *eol) {
+    int sz = (int)(_end - _p) < max ? (int)(_end - _p) : max;
+    const char *p1 = (const char*)memchr(_p, '\n', sz);
+    const char *p2 = (const char*)memchr(_p, '\r', sz);
+    if (p2 && (!p1 || p2 < p1)) p1 = p2;
+    int n = p1 ? (int)(p1 - _p) : sz;
+    memcpy(buf, _p, n);
+    _p  += n + (p1 ? 1 : 0);
+    *eol = p1 != NULL;
+    if (_p >= _end) _eof = 1;
+    return n;
+}
+#endif // !ARDUINO
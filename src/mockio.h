@@ -0,0 +1,74 @@
+/**
+ * @file
+ * @brief nanoForth mock Arduino Stream (host only)
+ *        + stdin, file, pipe and in-memory input backends
+ *        + bulk line fetch so scripts are not fed one char per call
+ */
+#ifndef __SRC_MOCKIO_H
+#define __SRC_MOCKIO_H
+
+#if !ARDUINO
+#include <cstdint>
+#include <cstdio>
+
+class Stream                           ///< Arduino Stream look-alike
+{
+protected:
+    FILE *_out;                        ///< output sink (stdout by default)
+    int  _eof { 0 };                   ///< input exhausted flag
+
+public:
+    Stream(FILE *out=stdout) : _out(out) {}
+    virtual ~Stream() {}
+    virtual int available() = 0;       ///< number of bytes readable without blocking
+    virtual int read() = 0;            ///< next byte, -1 if none
+    virtual int read_line(             ///< bulk fetch up to end of line (CR or LF consumed)
+        char *buf,                     ///< destination
+        int  max,                      ///< capacity of destination
+        int  *eol                      ///< set to 1 when end of line was reached
+        ) = 0;                         ///< @return number of bytes fetched
+    int  eof() { return _eof; }
+    int  availableForWrite() { return 0x7fff; }
+    size_t write(const uint8_t *p, size_t n) { return fwrite(p, 1, n, _out); }
+    void flush() { fflush(_out); }
+};
+///
+/// file descriptor backend (stdin, file or pipe)
+///
+class FileStream : public Stream
+{
+    int     _fd;                       ///< input file descriptor
+    FILE    *_pp { NULL };             ///< popen handle (for pipe)
+    uint8_t _buf[0x1000];              ///< input buffer
+    int     _hd { 0 }, _tl { 0 };      ///< buffer read, fill index
+
+    int  _fill(int wait);              ///< refill buffer, wait=0 polls only
+
+public:
+    FileStream(int fd=0, FILE *out=stdout) : Stream(out), _fd(fd) {}
+    ~FileStream();
+    int  open(const char *fname);      ///< read from a file, 1: ok
+    int  pipe(const char *cmd);        ///< read from output of a shell command, 1: ok
+    int  available() override;
+    int  read() override;
+    int  read_line(char *buf, int max, int *eol) override;
+};
+///
+/// in-memory backend (preloaded scripts, test harness)
+///
+class MemStream : public Stream
+{
+    const char *_p;                    ///< read pointer
+    const char *_end;                  ///< end of buffer
+
+public:
+    MemStream(const char *buf, size_t sz, FILE *out=stdout)
+        : Stream(out), _p(buf), _end(buf + sz) { _eof = !sz; }
+    int  available() override { return (int)(_end - _p); }
+    int  read() override;
+    int  read_line(char *buf, int max, int *eol) override;
+};
+
+extern FileStream Serial;              ///< console, on stdin/stdout
+#endif // !ARDUINO
+#endif // __SRC_MOCKIO_H
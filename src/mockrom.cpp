@@ -0,0 +1,40 @@
+/**
+ * @file
+ * @brief nanoForth mock EEPROM implementation (host only)
+ *        + a mapped file survives the process, so SAV, HBR images can be shared
+ */
+#include "mockrom.h"
+#if !ARDUINO
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static U8 _eeprom[EEPROM_SZ];          ///< default (volatile) mock EEPROM storage
+
+MockRom EEPROM;                        ///< mock EEPROM access object instance
+
+MockRom::MockRom() : _rom(_eeprom), _sz(EEPROM_SZ) {}
+///
+///> map an image file as EEPROM (file size capped at 64K, the 16-bit EEPROM index)
+///
+U8 MockRom::open(const char *fname, U16 sz)
+{
+    int fd = ::open(fname, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return 0;
+
+    struct stat st;
+    fstat(fd, &st);
+    U32 n = st.st_size > sz ? (U32)st.st_size : sz;
+    if (n > 0xffff) n = 0xffff;
+    if ((U32)st.st_size < n && ftruncate(fd, n)) { ::close(fd); return 0; }
+
+    void *m = mmap(NULL, n, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);                       /// * mapping stays valid after close
+    if (m == MAP_FAILED) return 0;
+
+    _rom = (U8*)m;
+    _sz  = (U16)n;
+    return 1;
+}
+#endif // !ARDUINO
@@ -1,22 +1,34 @@
 /**
  * @file
  * @brief nanoForth mock EEPROM interface class (for testing)
+ *        + memory-mapped host file backend, configurable size
  */
-#ifndef __SRC_EEPROM_H
-#define __SRC_EEPROM_H
+#ifndef __SRC_MOCKROM_H
+#define __SRC_MOCKROM_H
+#include "n4.h"
 
 #define EEPROM_SZ 0x400                /* default 1K */
 
 #if !ARDUINO
-static U8 _eeprom[EEPROM_SZ];          ///< mock EEPROM storage
+#include <cstring>                     // memcpy
 class MockRom                          ///< mock EEPROM access class
 {
+    U8  *_rom;                         ///< EEPROM storage (static array or mapped file)
+    U16 _sz;                           ///< EEPROM capacity in bytes
+
 public:
-    U16  length() { return EEPROM_SZ; }
-    U8   read(U16 idx) { return _eeprom[idx]; }
-    void update(U16 idx, U8 v) { _eeprom[idx] = v; }
+    MockRom();
+    U8   open(                         ///< map a host file as EEPROM, 1: ok
+        const char *fname,             ///< image file name (created if not exist)
+        U16 sz=EEPROM_SZ               ///< minimum capacity (file is extended to it)
+        );
+    U16  length() { return _sz; }
+    U8   read(U16 idx) { return _rom[idx]; }
+    void update(U16 idx, U8 v) { _rom[idx] = v; }
+    void read(U16 idx, U8 *p, U16 sz)   { memcpy(p, &_rom[idx], sz); }  ///< bulk read
+    void update(U16 idx, U8 *p, U16 sz) { memcpy(&_rom[idx], p, sz); }  ///< bulk write
 };
 
-MockRom EEPROM;                        ///< mock EEPROM access object instance
-#endif // ARDUINO
+extern MockRom EEPROM;                 ///< mock EEPROM access object instance
+#endif // !ARDUINO
 #endif // __SRC_MOCKROM_H
@@ -4,7 +4,9 @@
  *
  * Revision History: see tail of this file
  */
+#include "n4_core.h"
 #include "n4_vm.h"
+#include "n4_asm.h"
 
 FPTR NanoForth::fp[] = { NULL };
 ///
@@ -17,9 +19,9 @@ void NanoForth::add_api(int i, FPTR ufunc)
 ///
 ///> n4 VM init proxy
 ///
-void NanoForth::setup(const char *code, Stream &io, U8 ucase)
+void NanoForth::setup(const char *code, Stream &io, U8 ucase, U16 msz)
 {
-    N4VM::setup(code, io, ucase); /// * create Virtual Machine
+    N4VM::setup(code, io, ucase, msz); /// * create Virtual Machine
 }
 ///
 ///> n4 execute one line of commands from input buffer
@@ -42,6 +44,7 @@ void NanoForth::call_api(U16 id)
 void NanoForth::yield()
 {
 	N4VM::serv_isr();                          /// * service hardware interrupts
+    N4Core::flush(0);                          /// * drain console output without blocking
 }
 ///
 ///> aka Arduino delay(), yield to hardware context while waiting
@@ -56,36 +59,157 @@ void NanoForth::wait(U32 ms)
 ///
 void n4_push(int v) { N4VM::push(v);      }
 int  n4_pop()       { return N4VM::pop(); }
+int  n4_hibernate() { return N4VM::hibernate(); }
+int  n4_resume()    { return N4VM::resume();    }
+void n4_rom(U16 (*sz)(), void (*rd)(U16, U8*, U16), void (*wr)(U16, U8*, U16), int boot) {
+    U8 chg = N4Asm::set_rom(sz, rd, wr);
+    if (boot && chg && N4Core::dic) N4VM::restart();  /// * resume or autorun from the new backend
+}
 ///
 /// for Eclipse debugging
 ///
 #if ARDUINO
 NanoForth _n4;                   ///< singleton instance
 
-void n4_setup(const char *code, Stream &io, int ucase)  { _n4.setup(code); }
+void n4_setup(const char *code, Stream &io, int ucase, int msz) {
+    _n4.setup(code, io, ucase, (U16)msz);
+}
 void n4_api(int i, void (*fp)()) { _n4.add_api(i, fp); }
 void n4_run()                    { _n4.exec();         }
 #else // !ARDUINO
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "n4_core.h"
+#include "mockrom.h"
 void test1() {
 	int a = n4_pop();
 	int b = n4_pop();
 
 	n4_push(a + b);
 }
+///
+///> words translated ahead of time (see -c), a generated file linked in takes over
+///
+__attribute__((weak)) void n4_native() {}
+///
+///> read Forth source file into a null-terminated buffer
+///
+char *_read_src(const char *fname)
+{
+    FILE *f = fopen(fname, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long sz = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *buf = (char*)malloc(sz + 2);
+    sz = fread(buf, 1, sz, f);
+    buf[sz] = '\n'; buf[sz+1] = 0;         // make sure last line is terminated
+    fclose(f);
+    return buf;
+}
+///
+///> write dictionary image (EEPROM layout) or framed upload stream (see UPL_STX)
+///
+int _write_img(const char *fname, U8 autorun, U8 upl)
+{
+    FILE *f = fopen(fname, "wb");
+    if (!f) return -1;
 
+    U8  img[ROM_HDR + N4_MEM_MAX];
+    U16 sz = ROM_HDR + N4Asm::header(img, autorun);
+    N4Asm::flip();                          // image byte order
+    memcpy(&img[ROM_HDR], N4Core::dic, sz - ROM_HDR);
+    N4Asm::flip();
+    if (!upl) fwrite(img, 1, sz, f);
+    else {
+        fputs("UPL\n", f);
+        fputc(UPL_STX, f);
+        for (U16 i=0; i<sz; i+=UPL_FRM) {   // one frame per UPL_FRM bytes
+            U8  n = (sz - i) < UPL_FRM ? (U8)(sz - i) : UPL_FRM;
+            U16 s = N4Asm::csum(&img[i], n);
+            fputc(n, f);
+            fwrite(&img[i], 1, n, f);
+            fputc(s >> 8, f); fputc(s & 0xff, f);
+        }
+        fputc(0, f);                        // end of stream
+    }
+    fclose(f);
+    printf("\n%s: %d bytes\n", fname, sz);
+    return 0;
+}
+///
+///> host usage:
+///    n4                              - interactive console
+///    n4 [-a] [-o img] [-u upl] src   - cross-assemble src into dictionary image (-o)
+///                                      and/or upload stream for UPL (-u), -a for autorun
+///    n4 [-r rom] -c cpp [src]        - translate colon words into C++, link it in to run
+///                                      them as native code (see n4_native)
+///    n4 -r rom [-s sz] [src]         - use file rom as EEPROM (memory-mapped, sz bytes min)
+///                                      and start from the image or snapshot in it
+///    n4 [-f file | -p cmd]           - take console input from a file or a command's output
+///                                      instead of stdin, session ends with the input
+///    n4 -m sz                        - size of dictionary+stacks region (default 4K)
+///
 int main(int argc, char **argv)
 {
 	const char *code = "WRD\n123 456\n+\n";
-
-    setvbuf(stdout, NULL, _IONBF, 0);       // autoflush (turn STDOUT buffering off)
-
+    const char *img = NULL, *upl = NULL, *src = NULL, *rom = NULL;
+    const char *fin = NULL, *cmd = NULL, *aot = NULL;
+    U8  autorun = 0;
+    U16 rsz     = EEPROM_SZ;
+    U16 msz     = 0;
+    for (int i=1; i<argc; i++) {
+        if      (!strcmp(argv[i], "-a"))          autorun = 1;
+        else if (!strcmp(argv[i], "-o") && i+1<argc) img = argv[++i];
+        else if (!strcmp(argv[i], "-u") && i+1<argc) upl = argv[++i];
+        else if (!strcmp(argv[i], "-c") && i+1<argc) aot = argv[++i];
+        else if (!strcmp(argv[i], "-r") && i+1<argc) rom = argv[++i];
+        else if (!strcmp(argv[i], "-s") && i+1<argc) rsz = (U16)strtol(argv[++i], NULL, 0);
+        else if (!strcmp(argv[i], "-f") && i+1<argc) fin = argv[++i];
+        else if (!strcmp(argv[i], "-p") && i+1<argc) cmd = argv[++i];
+        else if (!strcmp(argv[i], "-m") && i+1<argc) msz = (U16)strtol(argv[++i], NULL, 0);
+        else src = argv[i];
+    }
+    if ((fin && !Serial.open(fin)) || (cmd && !Serial.pipe(cmd))) {
+        printf("%s: cannot open\n", fin ? fin : cmd);
+        return -1;
+    }
+    if (rom && !EEPROM.open(rom, rsz)) {
+        printf("%s: cannot map\n", rom);
+        return -1;
+    }
+    if (src && !(code = _read_src(src))) {
+        printf("%s: cannot open\n", src);
+        return -1;
+    }
+    n4_native();                            // register translated words, if linked in
     NanoForth n4;
-    n4.setup(code);
+    n4.setup(code, Serial, 0, msz);
     n4.add_api(0, test1);
-    while (1) {
+    if (rom && N4Asm::here==N4Core::dic) {  // not autorun nor resumed, take plain image
+        N4Asm::load();
+    }
+    if (img || upl || aot) {                // cross-assembler mode
+        N4Core::trc = 0;
+        while (N4Core::pending()) n4.exec();
+        N4Core::flush();
+        if (img && _write_img(img, autorun, 0)) return -1;
+        if (upl && _write_img(upl, autorun, 1)) return -1;
+#if N4_AOT
+        if (aot && N4Asm::aot(aot))             return -1;
+#else
+        if (aot) { printf("-c: built without N4_AOT\n"); return -1; }
+#endif // N4_AOT
+        return 0;
+    }
+    while (!Serial.eof() || N4Core::pending()) {
     	n4.exec();
+        if (!N4Core::pending() && !Serial.available() && !Serial.eof()) {
+            usleep(1000);                   // idle, wait for console input
+        }
     }
+    N4Core::flush();
     return 0;
 }
 #endif // !ARDUINO
@@ -4,19 +4,18 @@
  *
  * ####Memory Map
  *
- *    |paddr |forth |objects           |rom|
- *    |-----:|-----:|:----------------:|:-:|
- *    |0x0000|      |Interrupt Vectors |   |
- *    |0x0100|      |Arduino libraries |   |
- *    |0x02c0|0x0000|Dictionary==>     |x  |
- *    |      |      |...1K-byte...     |x  |
- *    |0x06c0|0x0400|Return Stack==>   |   |
- *    |      |      |...64 entries...  |   |
- *    |      |      |<==Data Stack     |   |
- *    |0x0740|0x0480|Input Buffer      |   |
- *    |      |      |...free memory... |   |
- *    |      |      |Arduino heap      |   |
- *    |0x0900|      |                  |   |
+ *    one region of msz bytes, sized at setup (all free RAM on AVR, less N4_MEM_RSV)
+ *
+ *    |forth |objects                      |
+ *    |-----:|:----------------------------:|
+ *    |0x0000|Dictionary==>                 |
+ *    |here  |line scratch (N4_LINE_RUN)    |
+ *    |rp0   |Return Stack==>               |
+ *    |      |...N4_STK_MIN at least...     |
+ *    |      |<==Data Stack                 |
+ *    |msz   |Input Buffer (N4_TIB_SZ)      |
+ *
+ *    rp0 moves up with here (mem_move carries the return stack), OVF! where rp meets sp
  */
 #ifndef __SRC_N4_H
 #define __SRC_N4_H
@@ -25,6 +24,94 @@
 #define APP_VERSION       "2.0 "
 #define N4_API_SZ         8       /**< C API function pointer slots */
 #define TRC_LEVEL         0       /**< tracing verbosity level      */
+///
+/// addressing mode, compact 12-bit branches (4K dictionary) by default on AVR and host
+/// (host images stay uploadable to AVR), 16-bit branches on larger MCUs
+///
+#ifndef N4_WIDE_ADR
+#if ARDUINO && !defined(__AVR__)
+#define N4_WIDE_ADR       1       /**< 3-byte branches, 16-bit dictionary offsets */
+#else
+#define N4_WIDE_ADR       0       /**< 2-byte branches, 12-bit dictionary offsets */
+#endif // ARDUINO && !__AVR__
+#endif // N4_WIDE_ADR
+///
+/// cell width, 16-bit on AVR and host (images stay portable), 32-bit on larger MCUs
+///
+#ifndef N4_CELL_SZ
+#if ARDUINO && !defined(__AVR__)
+#define N4_CELL_SZ        4       /**< 32-bit cells, double math in 64-bit */
+#else
+#define N4_CELL_SZ        2       /**< 16-bit cells, double math in 32-bit */
+#endif // ARDUINO && !__AVR__
+#endif // N4_CELL_SZ
+///
+/// byte order of code operands (literals, wide branch addresses) in RAM, images stay big-endian
+///
+#ifndef N4_NATIVE_END
+#if !defined(__AVR__) && defined(__BYTE_ORDER__) && (__BYTE_ORDER__==__ORDER_LITTLE_ENDIAN__)
+#define N4_NATIVE_END     1       /**< native order, word-wide loads, converted at SAV/LD/UPL */
+#else
+#define N4_NATIVE_END     0       /**< big-endian, byte by byte (AVR has no wider loads)     */
+#endif // !__AVR__ && LITTLE_ENDIAN
+#endif // N4_NATIVE_END
+
+///
+/// dense code, 2-byte short literals and 1-byte calls to hot words (images not interchangeable)
+///
+#ifndef N4_DENSE
+#define N4_DENSE          0       /**< 1: literals 0..119 in 1 byte, -256..255 in 2, 6 hot-call slots */
+#endif // N4_DENSE
+///
+/// stack effects inferred from code, SEE shows them, lines that cannot fit the stacks are refused
+///
+#ifndef N4_EFF
+#if defined(__AVR__)
+#define N4_EFF            0       /**< 0: lines run unchecked, flash kept for the application */
+#else
+#define N4_EFF            1       /**< 1: walk code for ( in -- out ) and stack peaks */
+#endif // __AVR__
+#endif // N4_EFF
+///
+/// WCT, best and worst case AVR cycles of a word, TMI warns when a handler may outrun its period
+///
+#ifndef N4_WCT
+#if defined(__AVR__)
+#define N4_WCT            0       /**< 0: WCT answers ?, TMI installs without the check */
+#else
+#define N4_WCT            1       /**< 1: walk code with a cycle table per opcode */
+#endif // __AVR__
+#endif // N4_WCT
+///
+/// OPT, in-place rewrite of colon words (inlining, tail calls, literal folding)
+///
+#ifndef N4_OPT
+#if defined(__AVR__)
+#define N4_OPT            0       /**< 0: OPT answers ? */
+#else
+#define N4_OPT            1       /**< 1: OPT rewrites words, the most called first */
+#endif // __AVR__
+#endif // N4_OPT
+///
+/// call counts per word, OPT rewrites the words called most
+///
+#ifndef N4_PROF
+#if defined(__AVR__)
+#define N4_PROF           0       /**< 0: calls not counted, no RAM or time spent per call */
+#else
+#define N4_PROF           1       /**< 1: count calls in 16 buckets hashed on the word address */
+#endif // __AVR__
+#endif // N4_PROF
+///
+/// words translated ahead of time into C++ (host n4 -c), calls into them run native code
+///
+#ifndef N4_AOT
+#if defined(__AVR__)
+#define N4_AOT            0       /**< 0: calls run bytecode only, no lookup per call */
+#else
+#define N4_AOT            1       /**< 1: calls look up the table registered by n4_native() */
+#endif // __AVR__
+#endif // N4_AOT
 
 ///@name Arduino Console Output Support
 ///@{
@@ -36,6 +123,7 @@
 #include <cstdint>                // uint_t
 #include <cstdio>                 // printf
 #include <cstdlib>                // malloc
+#include <cstring>                // memcpy, memcmp
 #include <iostream>
 #define PROGMEM
 #define millis()          10000
@@ -43,8 +131,7 @@
 #define pgm_read_byte(p)  (*(p))
 #define log(msg)          ::printf("%s", msg)
 #define logx(v)           ::printf("%x", (U16)v)
-#define Stream            int
-extern  int Serial;
+#include "mockio.h"               // Stream, Serial
 #endif // ARDUINO
 #define INLINE            inline __attribute__((always_inline))
 ///@}
@@ -53,9 +140,21 @@ extern  int Serial;
 ///@{
 typedef uint8_t      U8;          ///< 8-bit unsigned integer, for char and short int
 typedef uint16_t     U16;         ///< 16-bit unsigned integer, for return stack, and pointers
+typedef int8_t       S8;          ///< 8-bit signed integer, for stack depths
 typedef int16_t      S16;         ///< 16-bit signed integer, for general numbers
 typedef uint32_t     U32;         ///< 32-bit unsigned integer, for millis()
 typedef int32_t      S32;         ///< 32-bit signed integer
+#if N4_CELL_SZ==4
+typedef int32_t      DS;          ///< signed cell, for data stack
+typedef uint32_t     DU;          ///< unsigned cell, for return stack
+typedef int64_t      DD;          ///< double cell
+typedef uint64_t     UD;          ///< unsigned double cell
+#else
+typedef int16_t      DS;          ///< signed cell, for data stack
+typedef uint16_t     DU;          ///< unsigned cell, for return stack
+typedef int32_t      DD;          ///< double cell
+typedef uint32_t     UD;          ///< unsigned double cell
+#endif // N4_CELL_SZ
 typedef void (*FPTR)();           ///< function pointer
 ///@}
 ///
@@ -69,7 +168,8 @@ public:
     void setup(
     	const char *code=0,       ///< preload Forth code
         Stream &io=Serial,        ///< iostream which can be redirected to SoftwareSerial
-        U8 ucase=0                ///< case sensitiveness (default: sensitive)
+        U8 ucase=0,               ///< case sensitiveness (default: sensitive)
+        U16 msz=0                 ///< dictionary+stacks region size (default: all free RAM)
         );                        ///< placeholder for extra setup
     void exec();                  ///< nanoForth execute one line of command input
     //
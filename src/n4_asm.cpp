@@ -5,9 +5,10 @@
  * ####Assembler Memory Map:
  *
  * @code
- *    mem[...dic_sz...[...stk_sz...]
- *       |            |            |
- *       +-dic-->     +-->sp  rp<--+
+ *    mem[...dic...here[.....msz - here.....]
+ *       |             |                    |
+ *       +-dic-->      +-->rp          sp<--+
+ *                     rp0 (moves with here)
  * @endcode
  */
 #include "n4_asm.h"
@@ -29,17 +30,21 @@ using namespace N4Core;                       /// * make utilities available
 /// @brief words for branching ops in compile mode.
 /// @var PRM
 /// @brief primitive words (53 of 61 allocated, 3 pre-allocated).
+/// @var EXT
+/// @brief extended words, compiled as EXT prefix + index (mixed-precision, fixed-point, block ops)
 /// @var PMX
 /// @brief loop control opcodes
 ///
 ///@{
-PROGMEM const char IMM[] = "\xf"                                \
+PROGMEM const char IMM[] = "\x16"                               \
     ":  " "VAR" "VAL" "PCI" "TMI" "HEX" "DEC" "FGT" "WRD" "DMP" \
-    "SEE" "SAV" "LD " "SEX" "BYE";
+    "SEE" "SAV" "LD " "SEX" "BYE" "UPL" "HBR" "RSM" "DEF" "IS " \
+    "WCT" "OPT";
     // TODO: "s\" "
-PROGMEM const char JMP[] = "\x0b" \
+PROGMEM const char JMP[] = "\x16" \
     ";  " "IF " "ELS" "THN" "BGN" "UTL" "WHL" "RPT" "I  " "FOR" \
-    "NXT";
+    "NXT" "{  " "TO " "DO " "LOP" "+LP" "LVE" "CAS" "OF " "EOF" \
+    "ECS" "IS ";                                  // IS kept last, WRD lists it once (with IMM)
 
 #define N4_WORDS \
     "NOP" "DRP" "DUP" "SWP" "OVR" "ROT" "+  " "-  " "*  " "/  " \
@@ -56,11 +61,44 @@ PROGMEM const char PRM[] =
     "\x35" N4_WORDS;
 #endif // N4_DOES_META
 
+PROGMEM const char EXT[] = "\x13" \
+    "UM*" "M* " "UM/" "*/ " "*/M" "Q* " "Q/ " "F* " "S+ " "LRP" \
+    "TBL" "MOV" "FIL" "CMP" "SUM" "AMN" "AMX" "DOT" "CB!";
+
 PROGMEM const char PMX[] = "\x2" "I  " "FOR";
 ///@}
 ///
+#if N4_EFF
+///@name Stack Effects
+/// @brief data stack ( in -- out ) per opcode as 0xio, 0xff: unknown
+///@{
+PROGMEM const U8 PRM_EFF[] = {
+    0x00, 0x10, 0x12, 0x22, 0x23, 0x33, 0x21, 0x21, 0x21, 0x21, // NOP DRP DUP SWP OVR ROT + - * /
+    0x21, 0x11, 0x21, 0x21, 0x21, 0x11, 0x21, 0x21, 0x21, 0x21, // MOD NEG AND OR XOR NOT LSH RSH = <
+    0x21, 0x21, 0x11, 0x20, 0x11, 0x20, 0x01, 0x10, 0x00, 0x10, // > <> @ ! C@ C! KEY EMT CR .
+    0x00, 0x10, 0x01, 0x01, 0x11, 0x10, 0x10, 0x02, 0x42, 0x42, // ." >R R> HRE RND ALO TRC CLK D+ D-
+    0x22, 0x11, 0x21, 0x21, 0x10, 0x11, 0x11, 0x20, 0x20, 0x20, // DNG ABS MAX MIN DLY IN AIN OUT PWM PIN
+    0x10, 0x10, 0xff, 0x00, 0x10, 0x10, 0x01, 0xff, 0x00, 0x00, // TME PCE API CRE , C, ' EXE DO> EXT
+    0x00, 0x01, 0x10, 0x01                                      // LCL I FOR LIT
+};
+PROGMEM const U8 EXT_EFF[] = {
+    0x22, 0x22, 0x32, 0x31, 0x32, 0x21, 0x21, 0x21, 0x21, 0x31, // UM* M* UM/ */ */M Q* Q/ F* S+ LRP
+    0x21, 0x30, 0x30, 0x31, 0x22, 0x21, 0x21, 0x32, 0x20        // TBL MOV FIL CMP SUM AMN AMX DOT CB!
+};
+///@}
+#endif // N4_EFF
+///
 ///@name Branching
 ///@{
+#if N4_WIDE_ADR
+#define JMP00(j)      { ENC8(here, j); ENCA(here, 0); }
+#define JMPTO(idx, f) { ENC8(here, f); ENCA(here, idx); }
+#define JMPSET(idx, p1) do {               \
+    U8  *p = DIC(idx) + 1;                 \
+    ENCA(p, IDX(p1));                      \
+    } while(0)
+#define JADR(p)       GETA((U8*)(p) + 1)
+#else  // !N4_WIDE_ADR
 #define JMP00(j)      ENC16(here, (j)<<8)
 #define JMPTO(idx, f) ENC16(here, (idx) | ((f)<<8))
 #define JMPSET(idx, p1) do {               \
@@ -69,11 +107,14 @@ PROGMEM const char PMX[] = "\x2" "I  " "FOR";
     U16 a  = IDX(p1);                      \
     ENC16(p, (a | (U16)f8<<8));            \
     } while(0)
+#define JADR(p)       (GET16(p) & ADR_MASK)
+#endif // N4_WIDE_ADR
+#define NM(c)         ((c) & 0x7f)          /**< name character, high bit is hot-call slot */
 ///@}
 ///
 ///@name Stack Ops (note: return stack grows downward)
 ///@{
-#define RPUSH(a)       (*(vm.rp++)=(U16)(a))       /**< push address onto return stack */
+#define RPUSH(a)       (*(vm.rp++)=(DU)(a))        /**< push address onto return stack */
 #define RPOP()         (*(--vm.rp))                /**< pop address from return stack  */
 ///@}
 ///
@@ -82,16 +123,38 @@ PROGMEM const char PMX[] = "\x2" "I  " "FOR";
 #define DIC(n)         ((U8*)dic + (n))            /**< convert dictionary index to a memory pointer */
 #define IDX(p)         ((U16)((U8*)(p) - dic))     /**< convert memory pointer to a dictionary index */
 ///@}
-constexpr U16 N4_SIG  = (((U16)'N'<<8)+(U16)'4');  ///< EEPROM signature
-constexpr U16 N4_AUTO = N4_SIG | 0x8080;           ///< EEPROM auto-run signature
-constexpr U16 ROM_HDR = 6;                         ///< EEPROM header size
 constexpr U8  WORDS_PER_ROW = 16;                  ///< words per row when showing dictionary
 
 namespace N4Asm {
 
 U8  *last  { NULL };                ///< pointer to last word, for debugging
 U8  *here  { NULL };                ///< top of dictionary (exposed to _vm for HRE, ALO opcodes)
+U8  cmode { 0 };                    ///< compile mode flag (colon word in progress)
+#if N4_DENSE
+U16 hot[HOT_MAX];                   ///< hot-call table, slot+1 kept in name field high bits
+#endif // N4_DENSE
+#if N4_PROF
+U16 prof[PROF_SZ];                  ///< call counts per bucket of word address
+#endif // N4_PROF
 U8  tab = 0;                        ///< tracing indentation counter
+U8  *_l0, *_h0;                     ///< last, here before colon word (for rollback)
+#if N4_EFF
+void _d_eff(U16 xt);                ///< forward declaration, stack effect display
+#endif // N4_EFF
+///
+///@name Local Variables
+/// @brief
+///    { a b -- c } right after the name moves a, b from data stack into a frame on<br/>
+///    the return stack, a pushes a local, TO a stores one, ; drops the frame
+///@{
+U8  _nl  { 0 };                     ///< number of locals of the colon word in progress
+U8  _lrd { 0 };                     ///< cells above the frame at this point (FOR, >R)
+U8  _lst { 0 };                     ///< locals syntax state: 1 in { }, 2 after TO, 3 after --
+U8  _ldo { 0xff };                  ///< _lrd inside the innermost DO, 0xff: not in a DO loop
+U8  _lnm[LCL_MAX*3];                ///< names of locals
+///@}
+U8  *_lp { NULL };                  ///< last literal or word call compiled (for OF)
+U8  _is { 0 };                      ///< IS compiled, next token names the deferred word
 ///
 ///> find colon word address of next input token
 /// @brief search the keyword through colon word linked-list
@@ -102,9 +165,9 @@ U8  tab = 0;                        ///< tracing indentation counter
 U8 _find(U8 *tkn, U16 *adr)
 {
     for (U8 *p=last, *ex=DIC(LFA_END); p!=ex; p=DIC(GET16(p))) {
-        if (uc(p[2])==uc(tkn[0]) &&
-            uc(p[3])==uc(tkn[1]) &&
-            (p[3]==' ' || uc(p[4])==uc(tkn[2]))) {
+        if (uc(NM(p[2]))==uc(tkn[0]) &&
+            uc(NM(p[3]))==uc(tkn[1]) &&
+            (NM(p[3])==' ' || uc(NM(p[4]))==uc(tkn[2]))) {
             *adr = IDX(p);
             return 1;
         }
@@ -112,11 +175,33 @@ U8 _find(U8 *tkn, U16 *adr)
     return 0;
 }
 ///
+///> make room for n more bytes of dictionary (moves the dictionary/stack boundary)
+///
+U8 _room(U16 n)
+{
+    if (mem_fit(here + n)) return 1;
+    show("DIC!\n");
+    return 0;
+}
+///
+///> drop the colon word in progress, back to interpreter
+///
+void _rollback()
+{
+    last  = _l0;                    /// * restore last, here pointers
+    here  = _h0;
+    clear_tib();                    /// * reset tib and token parser
+    cmode = 0;
+    hot_scan();                     /// * slot given to the dropped word
+}
+///
 ///> create name field with link back to previous word
+/// @return 0: no name, input ended
 ///
-void _add_word()
+U8 _add_word()
 {
     U8  *tkn = get_token();         ///#### fetch one token from console
+    if (!tkn) return 0;
     U16 tmp  = IDX(last);           // link to previous word
 
     last = here;                    ///#### create 3-byte name field
@@ -124,12 +209,14 @@ void _add_word()
     ENC8(here, tkn[0]);             // nfa: store token into 3-byte name field
     ENC8(here, tkn[1]);
     ENC8(here, tkn[1]!=' ' ? tkn[2] : ' ');
+    return 1;
 }
 ///
 ///> create branching for instructions
 ///>> f IF...THN, f IF...ELS...THN
 ///>> BGN...f UTL, BGN...f WHL...RPT, BGN...f WHL...f UTL
 ///>> n1 n0 FOR...NXT
+///>> limit start DO...LOP, limit start DO...n +LP, LVE
 ///
 void _add_branch(U8 op)
 {
@@ -142,7 +229,7 @@ void _add_branch(U8 op)
         JMP00(OP_CDJ);                  // alloc addr with jmp_flag
         break;
     case 2: /* ELS */
-        JMPSET(RPOP(), here+2);         // update A1 with next addr
+        JMPSET(RPOP(), here+JMP_SZ);    // update A1 with next addr
         RPUSH(IDX(here));               // save current here A2
         JMP00(OP_UDJ);                  // alloc space with jmp_flag
         break;
@@ -160,7 +247,7 @@ void _add_branch(U8 op)
         JMP00(OP_CDJ);                  // allocate branch addr A2 with jmp flag
         break;
     case 7: /* RPT */
-        JMPSET(RPOP(), here+2);         // update A2 with next addr
+        JMPSET(RPOP(), here+JMP_SZ);    // update A2 with next addr
         JMPTO(RPOP(), OP_UDJ);          // unconditional jump back to A1
         break;
     case 8: /* I */
@@ -173,31 +260,233 @@ void _add_branch(U8 op)
     case 10: /* NXT */
         JMPTO(RPOP(), OP_NXT);          // loop back to A1
         break;
+    case 13: /* DO */
+        ENC8(here, PRM_OPS | I_EXT);    // loop frame builder
+        ENC8(here, X_DO);
+        RPUSH(IDX(here));               // save exit branch addr A1
+        JMP00(OP_UDJ);                  // alloc exit addr, body follows
+        break;
+    case 14: /* LOP */
+    case 15: /* +LP */ {
+        U16 a1 = RPOP();                // A1
+        ENC8(here, PRM_OPS | I_EXT);
+        ENC8(here, op==14 ? X_LOOP : X_PLOOP);
+        JMPTO(a1+JMP_SZ, OP_UDJ);       // loop back to body after A1
+        JMPSET(a1, here);               // exit of DO, i.e. LVE, lands here
+    } break;
+    case 16: /* LVE */
+        ENC8(here, PRM_OPS | I_EXT);
+        ENC8(here, X_LEAVE);
+        break;
+    }
+}
+///
+///> find a local by name
+/// @return index of local, or 0xff if not found
+///
+U8 _lfind(U8 *tkn)
+{
+    for (U8 i=0; i<_nl; i++) {
+        U8 *p = &_lnm[i*3];
+        if (uc(p[0])==uc(tkn[0]) &&
+            uc(p[1])==uc(tkn[1]) &&
+            (p[1]==' ' || uc(p[2])==uc(tkn[2]))) return i;
+    }
+    return 0xff;
+}
+///
+///> compile a local variable opcode
+///
+U8 _add_lcl(U8 op, S16 n)
+{
+    if (n < 0 || n > LCL_MASK) return 0; /// * R> without >R or frame too deep
+    ENC8(here, PRM_OPS | I_LCL);
+    ENC8(here, op | n);
+    return 1;
+}
+///
+///> handle a token inside { }, after TO, or a local reference
+/// @return 1: compiled, 0: error
+///
+U8 _local(U8 *tkn)
+{
+    U8 i   = _lfind(tkn);
+    U8 end = tkn[0]=='}' && tkn[1]==' ';
+    switch (_lst) {
+    case 1:                                 ///> declaring { a b
+        if (end) break;
+        if (tkn[0]=='-' && tkn[1]=='-' && tkn[2]==' ') { _lst = 3; return 1; }
+        if (_nl==LCL_MAX || i!=0xff) return 0;  /// * too many, or duplicated
+        i = _nl++ * 3;
+        _lnm[i]   = tkn[0];
+        _lnm[i+1] = tkn[1];
+        _lnm[i+2] = tkn[1]!=' ' ? tkn[2] : ' ';
+        return 1;
+    case 2:                                 ///> TO a
+        _lst = 0;
+        return i!=0xff && _add_lcl(LCL_SET, _nl + _lrd - i);
+    case 3:                                 ///> -- c }, outputs are comments
+        if (end) break;
+        return 1;
+    default: return _add_lcl(LCL_GET, _nl + _lrd - i);
+    }
+    _lst = 0;                               /// * closing }, build the frame
+    return _nl && _add_lcl(LCL_ENT, _nl);
+}
+///
+///> fetch the value of a literal at p, or of a VAL word called at p
+/// @return 1: a constant, 0: not one
+///
+U8 _lit_at(U8 *p, DS *v, U8 call)
+{
+    U8 op = *p;
+#if N4_DENSE
+    if (op >= OP_HOT && op < PRM_OPS) {
+        return call && _lit_at(DIC(hot[op - OP_HOT]), v, 0);   /// * VAL word, hot call
+    }
+    if (op==OP_SLIT || op==OP_SLIT+1) { *v = op==OP_SLIT ? p[1] : (DS)p[1] - 256; p += 2; }
+    else
+#endif // N4_DENSE
+    if (!(op & PRM_OPS))        { *v = op;                   p += 1;      }
+    else if (op==(PRM_OPS|I_LIT)) { *v = (DS)GETL(p+1);      p += LIT_SZ; }
+    else if (call && (op & JMP_MASK)==OP_CALL) {
+        return _lit_at(DIC(JADR(p)), v, 0);   /// * VAL word, [lit][RET]
+    }
+    else return 0;
+    return call || *p==(PRM_OPS|I_RET);
+}
+constexpr DU CS_CAS = 0xfffe;               ///< open CAS, no OF pending (beyond any code address)
+constexpr DU CS_OF  = 0xfffd;               ///< open OF, waiting for its EOF
+///
+///> compile CAS...n OF...EOF...ECS
+///>> return stack keeps CAS address, { val, body, exit jump }*n, n, and a CS_ marker on top
+///>> ECS builds a jump table for dense selectors, a value chain otherwise
+/// @return 1: ok, 0: error (OF EOF ECS out of place)
+///
+U8 _add_case(U8 op, U8 *lp)
+{
+    DU m = vm.rp > rp0 ? *(vm.rp-1) : 0;    // marker of innermost structure
+    if (op!=17 && m!=(op==19 ? CS_OF : CS_CAS)) return 0;
+    switch (op) {
+    case 17: /* CAS */
+        RPUSH(IDX(here));               // save CAS addr
+        ENC8(here, PRM_OPS | I_EXT);
+        ENC8(here, X_CAS);
+        JMP00(OP_UDJ);                  // table address, patched by ECS
+        RPUSH(0);                       // no OF yet
+        RPUSH(CS_CAS);
+        return 1;
+    case 18: /* OF */ {
+        DS v;
+        if (!lp || !_lit_at(lp, &v, 1)) return 0;  // value compiled just before OF
+        here = lp;                      // take it back out
+        vm.rp--;                        // marker
+        DU n = RPOP();
+        RPUSH(v);
+        RPUSH(IDX(here));               // body address
+        RPUSH(n);
+        RPUSH(CS_OF);
+    } return 1;
+    case 19: /* EOF */ {
+        vm.rp--;                        // marker
+        DU n = RPOP();
+        RPUSH(IDX(here));               // exit jump, patched by ECS
+        JMP00(OP_UDJ);
+        RPUSH(n + 1);
+        RPUSH(CS_CAS);
+    } return 1;
+    }
+    /* ECS */
+    vm.rp--;                            // marker
+    DU n  = RPOP();
+    DU *e = vm.rp - 3*n;                // first { val, body, exit }
+    U16 c = *(e-1);                     // CAS address
+    U16 d = n ? *(vm.rp-1) + JMP_SZ : c + X_LOOP_SZ;   // default follows last EOF
+    DS lo = n ? (DS)e[0] : 0, hi = lo;
+    for (DU i=0; i<n; i++) {
+        DS v = (DS)e[3*i];
+        if (v < lo) lo = v;
+        if (v > hi) hi = v;
+    }
+    UD span = (UD)(DU)((DU)hi - (DU)lo) + 1;
+    U8 jtb  = n && span <= 2*n && (N4_CELL_SZ + 2*span) <= 251;
+    U16 sz  = 3 + (jtb ? N4_CELL_SZ + 2*span : n*(N4_CELL_SZ + 2));
+    if (sz > 255 || !_room(1 + EXT_SZ + 1 + sz)) return 0;
+    e = vm.rp - 3*n;                    // room may have moved the return stack
+
+    ENC8(here, PRM_OPS | I_DRP);        // default drops the selector
+    U8 *t = here;
+    JMPSET(c + EXT_SZ, t);              // CAS branches to table
+    ENC8(here, PRM_OPS | I_EXT);
+    ENC8(here, jtb ? X_JTB : X_CHN);
+    ENC8(here, (U8)sz);
+    ENC8(here, (U8)(jtb ? span : n));
+    ENC16(here, d);
+    if (jtb) {
+        ENCC(here, lo);
+        U8 *a = here;
+        for (DU i=0; i<span; i++) ENC16(here, d);        // holes go to default
+        for (DU i=n; i--; ) {                            // first OF wins
+            U8 *p = a + 2*((DU)((DS)e[3*i] - lo));
+            ENC16(p, e[3*i+1]);
+        }
+    }
+    else {
+        for (DU i=0; i<n; i++) {
+            ENCC(here, e[3*i]);
+            ENC16(here, e[3*i+1]);
+        }
+    }
+    for (DU i=0; i<n; i++) JMPSET(e[3*i+2], here);        // EOFs exit past table
+    vm.rp = e - 1;                      // drop CAS frame
+    return 1;
+}
+///
+///> compile a number literal
+///
+void _add_lit(DU v)
+{
+    if (v <= LIT_MAX) {
+        ENC8(here, (U8)v);              /// * 1-byte literal, or
+    }
+#if N4_DENSE
+    else if ((DS)v >= -256 && (DS)v < 256) {
+        ENC8(here, OP_SLIT + ((DS)v < 0));  /// * 2-byte short literal, or
+        ENC8(here, (U8)v);
+    }
+#endif // N4_DENSE
+    else {
+        ENC8(here, PRM_OPS | I_LIT);    /// * cell-wide literal
+        ENCL(here, v);
     }
 }
 ///
 ///> display the opcode name
 ///
-void _add_str()
+U8 _add_str()
 {
     U8 *p0 = get_token();               // get string from input buffer
+    if (!p0) return 0;                  // input ended
     U8 sz  = 0;
-    for (U8 *p=p0; *p!='"'; p++, sz++);
+    for (U8 *p=p0; *p && *p!='"'; p++, sz++);   // unclosed, up to end of line
+    if (!_room(sz + 1)) return 0;
     ENC8(here, sz);
     for (int i=0; i<sz; i++) ENC8(here, *p0++);
+    return 1;
 }
 ///
 ///> list words in built-in vocabularies
 ///
 void _list_voc(U16 n)
 {
-    const char *lst[] PROGMEM = { IMM, JMP, PRM };      // list of built-in primitives
-    for (U8 i=0; i<3; i++) {
+    const char *lst[] PROGMEM = { IMM, JMP, PRM, EXT }; // list of built-in primitives
+    for (U8 i=0; i<4; i++) {
 #if ARDUINO
         U8 sz = pgm_read_byte(reinterpret_cast<PGM_P>(lst[i]));
 #else
         U8 sz = *(lst[i]);
 #endif //ARDUINO
+        if (lst[i]==JMP) sz--;                      /// * IS, compiled form shown with IMM
         while (sz--) {
             d_chr(n++%WORDS_PER_ROW ? ' ' : '\n');
             d_name(sz, lst[i], 1);
@@ -209,32 +498,35 @@ void _list_voc(U16 n)
 ///
 void save(U8 autorun)
 {
-    U16 here_i = IDX(here);
-
     if (trc) show("dic>>ROM ");
 
-    U16 last_i = IDX(last);
+#if N4_EFF
+    EffRec e;                                   ///> autorun word starts on empty stacks
+    if (autorun && IDX(last)!=LFA_END && effect(IDX(last) + 2 + 3, &e)) {
+        U16 room = (U16)(dic + msz - here) / sizeof(DU);
+        if (e.need > 0) { show("UDF!\n"); return; }
+        if ((U16)(e.dmax + e.rmax + 1) > room) { show("OVF!\n"); return; }
+        if (trc) {
+            show("stk "); d_num(e.dmax); d_chr('+'); d_num(e.rmax + 1); d_chr(' ');
+        }
+    }
+#endif // N4_EFF
+    U8  hdr[ROM_HDR];
+    U16 here_i = header(hdr, autorun);
     ///
     /// verify EEPROM capacity to hold user dictionary
     ///
-    if ((ROM_HDR + here_i) > EEPROM.length()) {
+    if ((ROM_HDR + here_i) > rom_size()) {
         show("ERROR: dictionary larger than EEPROM");
         return;
     }
     ///
-    /// create EEPROM dictionary header
-    ///
-    U16 sig = autorun ? N4_AUTO : N4_SIG;
-    EEPROM.update(0, sig>>8);    EEPROM.update(1, sig   &0xff);
-    EEPROM.update(2, last_i>>8); EEPROM.update(3, last_i&0xff);
-    EEPROM.update(4, here_i>>8); EEPROM.update(5, here_i&0xff);
-    ///
-    /// copy user dictionary into EEPROM byte-by-byte
+    /// create EEPROM dictionary header, and copy user dictionary
     ///
-    U8 *p = dic;
-    for (int i=0; i<here_i; i++) {
-        EEPROM.update(ROM_HDR+i, *p++);
-    }
+    rom_write(0, hdr, ROM_HDR);
+    flip();                                     /// * image byte order
+    rom_write(ROM_HDR, dic, here_i);
+    flip();
     if (trc) {
         d_num(here_i);
         show(" bytes saved\n");
@@ -252,7 +544,9 @@ U16 load(U8 autorun)
     ///
     /// validate EEPROM contains user dictionary (from previous run)
     ///
-    U16 n4 = ((U16)EEPROM.read(0)<<8) + EEPROM.read(1);
+    U8  hdr[ROM_HDR];
+    rom_read(0, hdr, ROM_HDR);
+    U16 n4 = GET16(hdr);
     if (autorun) {
         if (n4 != N4_AUTO) return LFA_END;          // EEPROM is not set to autorun
     }
@@ -260,20 +554,24 @@ U16 load(U8 autorun)
     ///
     /// retrieve metadata (sizes) of user dictionary
     ///
-    U16 last_i = ((U16)EEPROM.read(2)<<8) + EEPROM.read(3);
-    U16 here_i = ((U16)EEPROM.read(4)<<8) + EEPROM.read(5);
+    U16 last_i = GET16(hdr+2);
+    U16 here_i = GET16(hdr+4);
+    if (here_i > msz) return LFA_END;               // corrupted header
+    if (!mem_move(DIC(here_i))) return LFA_END;     // or, no room left for stacks
     ///
-    /// retrieve user dictionary byte-by-byte into memory
+    /// retrieve user dictionary into memory
     ///
-    U8 *p = dic;
-    for (int i=0; i<here_i; i++) {
-        *p++ = EEPROM.read(ROM_HDR+i);
-    }
+    rom_read(ROM_HDR, dic, here_i);
     ///
     /// adjust user dictionary pointers
     ///
     last = DIC(last_i);
     here = DIC(here_i);
+    flip();                                     /// * to native byte order
+    hot_scan();
+#if N4_PROF
+    memset(prof, 0, sizeof(prof));              /// * counts were for other words
+#endif // N4_PROF
 
     if (trc && !autorun) {
         d_num(here_i);
@@ -282,6 +580,248 @@ U16 load(U8 autorun)
     return last_i;
 }
 ///
+///> persistence backend, built-in EEPROM by default
+///
+U16  _ee_size() { return EEPROM.length(); }
+#if ARDUINO
+void _ee_read(U16 idx, U8 *p, U16 sz) {
+    while (sz--) *p++ = EEPROM.read(idx++);
+}
+void _ee_write(U16 idx, U8 *p, U16 sz) {
+    while (sz--) EEPROM.update(idx++, *p++);    /// * update spares EEPROM write cycles
+}
+#else  // !ARDUINO
+void _ee_read(U16 idx, U8 *p, U16 sz)  { EEPROM.read(idx, p, sz);   }  /// * bulk memcpy
+void _ee_write(U16 idx, U8 *p, U16 sz) { EEPROM.update(idx, p, sz); }
+#endif // ARDUINO
+ROM_SZ _rom_sz { _ee_size  };       ///< backend capacity
+ROM_IO _rom_rd { _ee_read  };       ///< backend bulk reader
+ROM_IO _rom_wr { _ee_write };       ///< backend bulk writer
+
+U8 set_rom(ROM_SZ sz, ROM_IO rd, ROM_IO wr) {
+    if (!sz) sz = _ee_size;
+    if (!rd) rd = _ee_read;
+    if (!wr) wr = _ee_write;
+    U8 chg = sz!=_rom_sz || rd!=_rom_rd || wr!=_rom_wr;
+    _rom_sz = sz;
+    _rom_rd = rd;
+    _rom_wr = wr;
+    return chg;
+}
+U16  rom_size() { return _rom_sz(); }
+void rom_read(U16 idx, U8 *p, U16 sz) {
+    if ((U32)idx + sz <= rom_size()) _rom_rd(idx, p, sz);
+}
+void rom_write(U16 idx, U8 *p, U16 sz) {
+    if ((U32)idx + sz <= rom_size()) _rom_wr(idx, p, sz);
+}
+///
+///> fill image header (signature, last, here), shared by EEPROM and host images
+/// @return
+///    number of dictionary bytes following the header
+///
+U16 header(U8 *hdr, U8 autorun)
+{
+    U16 sig    = autorun ? N4_AUTO : N4_SIG;
+    U16 last_i = IDX(last);
+    U16 here_i = IDX(here);
+    U8  *p     = hdr;
+    ENC16(p, sig);
+    ENC16(p, last_i);
+    ENC16(p, here_i);
+
+    return here_i;
+}
+///
+///> Fletcher-16 checksum (catches swapped and dropped bytes, cheap on AVR)
+///
+U16 csum(U8 *p, U8 sz)
+{
+    U16 s1 = 0, s2 = 0;
+    while (sz--) {
+        s1 = (s1 + *p++) % 255;
+        s2 = (s2 + s1)   % 255;
+    }
+    return (s2 << 8) | s1;
+}
+///
+///> receive a framed binary dictionary image (see UPL_STX) straight into dic
+/// @brief
+///    each frame is acknowledged with a '.', a bad checksum, oversized frame or image aborts<br/>
+///    the upload (the rest of the stream still drained) and the previously saved dictionary<br/>
+///    is restored from EEPROM
+///
+void upload()
+{
+    U8  hdr[ROM_HDR];
+    U8  buf[UPL_FRM];
+    U16 n   = 0;                            ///< bytes received (header included)
+    U8  err = 0;
+
+    while ((U8)key() != UPL_STX && !eof()); /// * skip line ending left before stream
+    for (U8 sz=(U8)key(); sz; sz=(U8)key()) {
+        if (sz > UPL_FRM) err = 1;          /// * oversized, drained frame by frame to end of stream
+        for (U8 i=0; i<sz; i++) {
+            U8 c = (U8)key();
+            if (i < UPL_FRM) buf[i] = c;
+        }
+        U16 s = (U16)(U8)key() << 8;
+        s |= (U8)key();
+        if (err) continue;                  /// * drain rest of the stream
+        if (s != csum(buf, sz)) { err = 1; continue; }
+        for (U8 i=0; i<sz; i++, n++) {      /// * header first, then dictionary
+            if (n < ROM_HDR)                 hdr[n] = buf[i];
+            else if (mem_fit(DIC(n - ROM_HDR + 1))) dic[n - ROM_HDR] = buf[i];  /// * moves rp0 up
+            else err = 1;
+        }
+        d_chr('.');
+    }
+    if (!err && n >= ROM_HDR) {
+        U16 sig    = GET16(hdr);
+        U16 last_i = GET16(hdr+2);
+        U16 here_i = GET16(hdr+4);
+        if ((sig==N4_SIG || sig==N4_AUTO) && here_i == n - ROM_HDR &&
+            (last_i < here_i || last_i==LFA_END)) {
+            last = DIC(last_i);
+            here = DIC(here_i);
+            flip();                         /// * to native byte order
+            hot_scan();
+            save(sig==N4_AUTO);             /// * persist (keeps autorun flag)
+            d_num(here_i); show(" bytes uploaded\n");
+            return;
+        }
+    }
+    show("CRC!\n");                         /// * corrupted, roll back to EEPROM
+    here = dic;
+    last = DIC(LFA_END);
+    hot_scan();
+    if (load()==LFA_END) load(1);
+}
+///
+///> size of instruction at p (code walkers)
+///
+U8 _op_sz(U8 *p)
+{
+    U8 op = *p;
+    if ((op & CTL_BITS)==JMP_OPS) return JMP_SZ;         ///> branch
+    if ((op & CTL_BITS)!=PRM_OPS) {                      ///> number, or hot call
+#if N4_DENSE
+        return (op==OP_SLIT || op==OP_SLIT+1) ? 2 : 1;
+#else
+        return 1;
+#endif // N4_DENSE
+    }
+    op &= PRM_MASK;                                      ///> primitive
+    return op==I_LIT ? LIT_SZ
+        : (op==I_EXT && p[1]>=X_JTB) ? EXT_SZ + 1 + p[2] /// * CAS table
+        : ((op==I_EXT || op==I_LCL) ? EXT_SZ : (op==I_DQ ? 2 + p[1] : 1));
+}
+///
+///> literal at p
+/// @return its size, 0: not a literal
+///
+U8 _num(U8 *p, DS *v)
+{
+    U8 op = *p;
+#if N4_DENSE
+    if (op==OP_SLIT || op==OP_SLIT+1) { *v = op==OP_SLIT ? p[1] : (DS)p[1] - 256; return 2; }
+    if (op >= OP_HOT && op < PRM_OPS) return 0;
+#endif // N4_DENSE
+    if (!(op & PRM_OPS))          { *v = op;               return 1; }
+    if (op==(PRM_OPS|I_LIT))      { *v = (DS)GETL(p+1);    return LIT_SZ; }
+    return 0;
+}
+///
+///> size of instruction for the walker, DO LOP +LP CAS DOES include their branch
+///
+U8 _eff_sz(U8 *p)
+{
+    if (*p==(PRM_OPS|I_EXT) && p[1]>=X_DO && p[1]<X_JTB &&
+        p[1]!=X_LEAVE && p[1]!=X_IS) return X_LOOP_SZ;
+    return _op_sz(p);
+}
+#if N4_NATIVE_END
+///
+///> reverse byte order of an operand in place
+///
+void _swap(U8 *p, U8 n)
+{
+    for (U8 *q=p+n-1; p < q; p++, q--) { U8 t = *p; *p = *q; *q = t; }
+}
+#endif // N4_NATIVE_END
+///
+///> swap code operands (I_LIT literals, wide branch addresses) between native and
+///> image (big-endian) byte order, its own inverse
+/// @brief
+///    walks each word from its parameter field to the first RET, data after it<br/>
+///    (VAR storage, , C, ALO) is accessed byte-wise by @ ! and left untouched
+///
+void flip()
+{
+#if N4_NATIVE_END
+    U8 *end = here;
+    for (U8 *w=last, *ex=DIC(LFA_END); w!=ex; end=w, w=DIC(GET16(w))) {
+        for (U8 *p=w+2+3; p < end && *p!=(PRM_OPS|I_RET); p += _op_sz(p)) {
+#if N4_WIDE_ADR
+            if ((*p & CTL_BITS)==JMP_OPS) _swap(p+1, 2);       ///> branch
+#endif // N4_WIDE_ADR
+            if (*p==(PRM_OPS|I_LIT)) _swap(p+1, N4_CELL_SZ);   ///> literal
+        }
+    }
+#endif // N4_NATIVE_END
+}
+///
+///> rebuild hot-call table from slot numbers kept in name field high bits
+///
+void hot_scan()
+{
+#if N4_DENSE
+    for (U8 k=0; k<HOT_MAX; k++) hot[k] = 0;
+    for (U8 *w=last, *ex=DIC(LFA_END); w!=ex; w=DIC(GET16(w))) {
+        U8 k = (w[2]>>7) | ((w[3]>>7)<<1) | ((w[4]>>7)<<2);  ///< slot + 1
+        if (k) hot[k-1] = IDX(w) + 2 + 3;
+    }
+#endif // N4_DENSE
+}
+#if N4_DENSE
+///
+///> check whether any colon word already calls xt
+///
+U8 _called(U16 xt)
+{
+    U8 *end = here;
+    for (U8 *w=last, *ex=DIC(LFA_END); w!=ex; end=w, w=DIC(GET16(w))) {
+        for (U8 *p=w+2+3; p < end && *p!=(PRM_OPS|I_RET); p += _op_sz(p)) {
+            if ((*p & JMP_MASK)==OP_CALL && JADR(p)==xt) return 1;
+        }
+    }
+    return 0;
+}
+///
+///> compile a 1-byte call to word at lfa, a word called twice takes a free slot
+/// @return 1: compiled, 0: no slot, use a CALL
+///
+U8 _add_hot(U16 lfa, U8 take)
+{
+    U8 *w = DIC(lfa);
+    U16 xt = lfa + 2 + 3;
+    U8  k  = 0;
+    while (k < HOT_MAX && hot[k]!=xt) k++;
+    if (k==HOT_MAX) {                               ///> not hot yet
+        if (!take || !_called(xt)) return 0;        /// * first call, stays a CALL
+        for (k=0; k < HOT_MAX && hot[k]; k++);
+        if (k==HOT_MAX) return 0;                   /// * table full
+        hot[k] = xt;
+        U8 n = k + 1;                               ///> slot+1 into name field
+        w[2] |= (n & 1) << 7;
+        w[3] |= (n & 2) << 6;
+        w[4] |= (n & 4) << 5;
+    }
+    ENC8(here, OP_HOT + k);
+    return 1;
+}
+#endif // N4_DENSE
+///
 ///> reset internal pointers (called by VM::reset)
 /// @return
 ///  1: autorun last word from EEPROM
@@ -292,6 +832,11 @@ U16 reset()
     here    = dic;                       // rewind to dictionary base
     last    = DIC(LFA_END);              // root of linked field
     tab     = 0;
+    cmode   = 0;
+    hot_scan();                          // no hot words
+#if N4_PROF
+    memset(prof, 0, sizeof(prof));       // no calls counted
+#endif // N4_PROF
     
 #if ARDUINO
     trc = 0;
@@ -306,7 +851,8 @@ U16 reset()
 ///
 U16 query() {
     U16 adr;                        ///< lfa of word
-    if (!_find(get_token(), &adr)) {/// check if token is in dictionary
+    U8  *tkn = get_token();
+    if (!tkn || !_find(tkn, &adr)) {/// check if token is in dictionary
         show("?!  ");               /// * not found, bail
         return 0;
     }
@@ -315,92 +861,238 @@ U16 query() {
 ///
 ///> parse given token into actionable item
 ///
-N4OP parse(U8 *tkn, U16 *rst, U8 run)
+N4OP parse(U8 *tkn, DU *rst, U8 run)
 {
-    if (_find(tkn, rst))                 return TKN_WRD; /// * WRD - is a colon word? [lnk(2),name(3)]
-    if (scan(tkn, run ? IMM : JMP, rst)) return TKN_IMM; /// * IMM - is a immediate word?
-    if (scan(tkn, PRM, rst))             return TKN_PRM; /// * PRM - is a primitives?
-    if (number(tkn, (S16*)rst))          return TKN_NUM; /// * NUM - is a number literal?
-    return TKN_ERR;                                      /// * ERR - unknown token
+    U16  id;
+    N4OP op = TKN_ERR;                                   /// * ERR - unknown token
+    if      (_find(tkn, &id))                 op = TKN_WRD; /// * WRD - is a colon word? [lnk(2),name(3)]
+    else if (scan(tkn, run ? IMM : JMP, &id)) op = TKN_IMM; /// * IMM - is a immediate word?
+    else if (scan(tkn, PRM, &id))             op = TKN_PRM; /// * PRM - is a primitives?
+    else if (scan(tkn, EXT, &id))             op = TKN_EXT; /// * EXT - is an extended word?
+    else if (number(tkn, (DS*)rst))           return TKN_NUM; /// * NUM - is a number literal?
+    if (op != TKN_ERR) *rst = id;
+    return op;
 }
 ///
 ///> Forth assembler (creates word onto dictionary)
 ///
-void compile(U16 *rp0)
+void compile(DU *rp0)
 {
-    vm.rp = rp0;                       // set return stack pointer
-    U8 *l0 = last, *h0 = here;
-    U8 *p0 = here;
-
-    _add_word();                    /// **fetch token, create name field linked to previous word**
+    vm.rp = rp0;                    // set return stack pointer
+    _l0   = last;                   // keep last, here for rollback
+    _h0   = here;
+    _nl   = _lrd = _lst = _is = 0;  // no locals yet, no IS pending
+    _ldo  = 0xff;                   // not in a DO loop
+    _lp   = NULL;
+    if (!_room(5)) {                // link + name
+        clear_tib();
+        return;
+    }
 
-    for (U8 *tkn=p0; tkn;) {        ///> loop til exhaust all tokens (tkn==NULL)
-        U16 tmp;
-        if (trc) d_mem(dic, p0, (U16)(here-p0), 0);  ///>> trace assembler progress if enabled
+    if (!_add_word()) return;       /// **fetch token, create name field linked to previous word**
 
-        tkn = get_token();
-        p0  = here;                         // keep current top of dictionary (for memdump)
-        switch(parse(tkn, &tmp, 0)) {       ///>> **determine type of operation, and keep opcode in tmp**
-        case TKN_IMM:                       ///>> an immediate command?
-            _add_branch(tmp);               /// * add branching opcode
-            if (tmp==I_RET) {
-                tkn = NULL;                 /// * clear token to exit compile mode
-                if (trc) d_mem(dic, last, (U16)(here-last), ' ');  ///> debug memory dump, if enabled
-            }
-            break;
-        case TKN_WRD:                       ///>> a colon word? [addr + lnk(2) + name(3)]
-            JMPTO(tmp+2+3, OP_CALL);        /// * call subroutine
+    if (trc) d_mem(dic, _h0, (U16)(here-_h0), 0);    ///>> trace assembler progress if enabled
+    cmode = 1;                      /// * tokens are fed by outer interpreter from now on
+}
+///
+///> compile one token into the colon word in progress
+///  * called by outer interpreter, so input never blocks between lines of a definition
+///
+void compile(U8 *tkn)
+{
+    DU  tmp;
+    U8  *p0 = here;                         // keep current top of dictionary (for memdump)
+    if (!_room(OPS_MAX)) { _rollback(); return; } /// * longest opcode (." checks its own string)
+    U8  *lp = _lp;                          // literal or call just before (for OF)
+    _lp = NULL;
+    if (_is) {                              ///>> IS name, [LIT pfa][EXT X_IS]
+        U16 w;
+        _is = 0;
+        if (!_find(tkn, &w) || !_room(LIT_SZ + EXT_SZ)) { show("??  "); _rollback(); return; }
+        _add_lit(w+2+3);
+        ENC8(here, PRM_OPS | I_EXT);
+        ENC8(here, X_IS);
+        if (trc) d_mem(dic, p0, (U16)(here-p0), 0);
+        return;
+    }
+    if (_lst || (_nl && _lfind(tkn)!=0xff)) {   ///>> locals syntax, or a local variable
+        if (!_local(tkn)) { show("??  "); _rollback(); return; }
+        if (trc) d_mem(dic, p0, (U16)(here-p0), 0);
+        return;
+    }
+    switch(parse(tkn, &tmp, 0)) {           ///>> **determine type of operation, and keep opcode in tmp**
+    case TKN_IMM:                           ///>> an immediate command?
+        if (tmp==11 || tmp==12) {           /// * { must follow the name, TO needs locals
+            if (tmp==11 ? here!=last+2+3 : !_nl) { show("??  "); _rollback(); return; }
+            _lst = tmp==11 ? 1 : 2;
             break;
-        case TKN_PRM:                       ///>> a built-in primitives?
-            ENC8(here, PRM_OPS | (U8)tmp);  /// * add found primitive opcode
-            if (tmp==I_DQ) _add_str();      /// * do extra, if it's a ." (dot_string) command
+        }
+        if (tmp==21) { _is = 1; break; }    /// * IS, patch target named next
+        if (tmp >= 17) {                    /// * CAS OF EOF ECS
+            if (!_add_case(tmp, lp)) { show("??  "); _rollback(); return; }
+            if (here < p0) p0 = here;       /// * OF took its value back out
             break;
-        case TKN_NUM:                       ///>> a literal (number)?
-            if (tmp < 128) {
-                ENC8(here, (U8)tmp);        /// * 1-byte literal, or
+        }
+        if (tmp==I_RET && vm.rp > rp0 &&    /// * CAS left open
+            (*(vm.rp-1)==CS_CAS || *(vm.rp-1)==CS_OF)) { show("??  "); _rollback(); return; }
+        if (tmp==I_RET && _nl) _add_lcl(LCL_END, _nl);  /// * drop locals frame
+        if (tmp==9)  _lrd++;                /// * FOR counter sits above the frame
+        if (tmp==10) _lrd--;
+        if (tmp==13) _lrd += 3;             /// * so does a DO loop frame
+        if (tmp==14 || tmp==15) { _lrd -= 3; _ldo = (U8)RPOP(); }
+        if (tmp==16 && _ldo!=_lrd) {        /// * LVE drops a DO frame, which must be on top
+            show("??  "); _rollback(); return;
+        }
+        _add_branch(tmp);                   /// * add branching opcode
+        if (tmp==13) { RPUSH(_ldo); _ldo = _lrd; }  /// * enclosing DO, back at LOP
+        if (tmp==I_RET) {
+            cmode = 0;                      /// * exit compile mode
+            if (trc) {                      ///> debug memory dump, if enabled
+                d_mem(dic, last, (U16)(here-last), ' ');
+#if N4_EFF
+                _d_eff(IDX(last) + 2 + 3);  /// * and inferred stack effect
+#endif // N4_EFF
             }
-            else {
-                ENC8(here, PRM_OPS | I_LIT);/// * 3-byte literal
-                ENC16(here, tmp);
+            return;
+        }
+        break;
+    case TKN_WRD:                           ///>> a colon word? [addr + lnk(2) + name(3)]
+        _lp = here;
+#if N4_DENSE
+        if (_add_hot(tmp, 1)) break;        /// * 1-byte call to a hot word
+#endif // N4_DENSE
+        JMPTO(tmp+2+3, OP_CALL);            /// * call subroutine
+        break;
+    case TKN_PRM:                           ///>> a built-in primitives?
+        ENC8(here, PRM_OPS | (U8)tmp);      /// * add found primitive opcode
+        if (tmp==31) _lrd++;                /// * >R, R> move cells above the frame
+        if (tmp==32) _lrd--;
+        if (tmp==I_DQ && !_add_str()) {     /// * do extra, if it's a ." (dot_string) command
+            _rollback();
+            return;
+        }
+        break;
+    case TKN_NUM:                           ///>> a literal (number)?
+        _lp = here;
+        _add_lit(tmp);
+        break;
+    case TKN_EXT:                           ///>> an extended word?
+        ENC8(here, PRM_OPS | I_EXT);        /// * prefix + index into EXT list
+        ENC8(here, (U8)tmp);
+        break;
+    default:                                ///>> then, token type not found
+        show("??  ");
+        _rollback();                        /// * bail, back to interpreter
+        return;
+    }
+    if (trc) d_mem(dic, p0, (U16)(here-p0), 0);  ///>> trace assembler progress if enabled
+}
+constexpr U8  LN_LVL  = 8;                  ///< nested calls walked for a compiled line
+constexpr U16 LN_WALK = 512;                ///< instructions walked for a compiled line
+///
+///> whether code at xt, or a word it calls, may move here (, C, ALO CRE EXE, deferred)
+/// @return 1: may grow, or not known within lvl calls and n instructions
+///
+U8 _grows(U16 xt, U8 lvl, U16 *n)
+{
+    U8 *p = DIC(xt), *e, *q;
+    if (!lvl || (*p & JMP_MASK)==OP_UDJ) return 1;         /// * deferred, IS may repoint it
+    for (e=p; *e!=(PRM_OPS|I_RET); e+=_op_sz(e));
+    for (q=p; q < e; q+=_op_sz(q)) {
+        if (!(*n)--) return 1;
+        U8  op = *q;
+        U16 w;
+        if ((op & CTL_BITS)==JMP_OPS) {
+            w = JADR(q);
+            U8 k = op & JMP_MASK;
+            if (k!=OP_CALL && (k!=OP_UDJ || (w >= xt && w <= IDX(e)))) continue;
+        }                                                   /// * call, tail jump or DOES
+#if N4_DENSE
+        else if (op >= OP_HOT && op < PRM_OPS) w = hot[op - OP_HOT];
+#endif // N4_DENSE
+        else if ((op & CTL_BITS)==PRM_OPS) {
+            op &= PRM_MASK;
+            if (op==I_ALO || (op >= I_CRE && op <= I_EXE)) return 1;
+            continue;
+        }
+        else continue;
+        if (w!=xt && _grows(w, lvl - 1, n)) return 1;      /// * recursion adds nothing
+    }
+    return 0;
+}
+///
+///> compile rest of the input line at here, for interpret mode to run with _nest
+/// @brief
+///    words that define, read input or move here (IMM, ;, CRE, ', ALO...) can not<br/>
+///    be compiled ahead, so such a line is left to the token-by-token interpreter,<br/>
+///    so is a line calling words that move here, they would overwrite it
+/// @return
+///    1: line compiled and closed with RET<br/>
+///    0: line must be interpreted (tokens taken, caller rewinds)
+///
+U8 line(DU *rp0)
+{
+    U16 xt = IDX(here);
+    vm.rp = rp0;                            // return stack keeps branch addresses
+    while (!eol()) {
+        DU  tmp;
+        U8  *tkn = get_token();
+        if (!tkn) return 0;
+        switch (parse(tkn, &tmp, 0)) {
+        case TKN_IMM:                       ///>> branching (JMP list)
+            if (tmp==I_RET || tmp>10) return 0; /// * ; { TO outside of a definition
+            if (vm.rp - rp0 < (tmp==7 ? 2 : (tmp==2||tmp==3||tmp==5||tmp==10))) {
+                return 0;                   /// * ELS, THN, UTL, RPT, NXT without opener
             }
+            _add_branch(tmp);
+            break;
+        case TKN_WRD:
+#if N4_DENSE
+            if (_add_hot(tmp, 0)) break;    /// * slots are only taken by colon words
+#endif // N4_DENSE
+            JMPTO(tmp+2+3, OP_CALL);
+            break;
+        case TKN_PRM:
+            if (tmp==I_ALO || (tmp>=I_CRE && tmp!=I_EXE)) return 0;
+            ENC8(here, PRM_OPS | (U8)tmp);
+            if (tmp==I_DQ && !_add_str()) return 0;
+            break;
+        case TKN_EXT:
+            ENC8(here, PRM_OPS | I_EXT);
+            ENC8(here, (U8)tmp);
+            break;
+        case TKN_NUM:
+            _add_lit(tmp);
             break;
-        case TKN_EXT:                       ///>> extended words, not implemented yet
-        default:                            ///>> then, token type not found
-            show("??  ");
-            last = l0;                      /// * restore last, here pointers
-            here = h0;
-            clear_tib();                    /// * reset tib and token parser
-            tkn  = NULL;                    /// * bail, terminate loop!
+        default: return 0;                  ///>> immediate or unknown word
         }
     }
+    ENC8(here, PRM_OPS | I_RET);
+    if (vm.rp!=rp0) return 0;               /// * IF, BGN, FOR must be closed on the same line
+    U16 n = LN_WALK;
+    return !_grows(xt, LN_LVL, &n);         /// * code runs from scratch space above here
 }
 ///
 ///> meta compiler
 ///
 void create() {                             ///> create a word header (link + name field)
-    _add_word();                            /// **fetch token, create name field linked to previous word**
+    if (!_room(6+X_LOOP_SZ)) { clear_tib(); return; } /// * header + DOES + RET
+    if (!_add_word()) return;               /// **fetch token, create name field linked to previous word**
 
-    U8 tmp = IDX(here+2);                   // address to variable storage
-    if (tmp < 128) {                        ///> handle 1-byte address + RET(1)
-        ENC8(here, (U8)tmp);
-    }
-    else {
-        tmp += 2;                           ///> or, extra bytes for 16-bit address
-        ENC8(here, PRM_OPS | I_LIT);
-        ENC16(here, tmp);
-    }
+    U16 r = IDX(here) + X_LOOP_SZ;          ///< its own RET, until DO> patches the jump
+    ENC8(here, PRM_OPS | I_EXT);            ///> [EXT X_DOES][UDJ r][RET], data field follows
+    ENC8(here, X_DOES);
+    JMPTO(r, OP_UDJ);
     ENC8(here, PRM_OPS | I_RET);
 }
-void comma(S16 v)  { ENC16(here, v); }      ///> compile a 16-bit value onto dictionary
-void ccomma(S16 v) { ENC8(here, v);  }      ///> compile a 16-bit value onto dictionary
+void comma(DS v)  { if (_room(N4_CELL_SZ)) ENCC(here, v); } ///> compile a cell onto dictionary
+void ccomma(DS v) { if (_room(1)) ENC8(here, v); }          ///> compile a 8-bit value onto dictionary
+void allot(DS n)  { if (n < 0 || _room(n)) here += n; }     ///> reserve (or give back) dictionary space
 void does(U16 xt)  {                        ///> metaprogrammer (jump to definding word DO> section)
 #if N4_DOES_META
-	U8 *p = here - 1;                               /// start walking back
-    for (; *p!=(PRM_OPS|I_RET); p--) *(p+2) = *p;   /// shift down parameters by 2 bytes
-    *(p-1) += 2;                                    /// adjust the PFA
-    ENC16(p, xt | (OP_UDJ << 8));                   /// replace RET with a JMP,
-	ENC8(p, PRM_OPS|I_RET);                         /// and a RET, (not necessary but nice to SEE)
-	here += 2;                                      /// extra 2 bytes due to shift
+    U8 *pf = last + 2 + 3;                          /// parameter field of the CREated word
+    if (pf[0]!=(PRM_OPS|I_EXT) || pf[1]!=X_DOES) return;
+    JMPSET(IDX(pf) + EXT_SZ, DIC(xt));              /// point its DOES jump to DO> section
 #endif // N4_DOES_META
 }
 ///
@@ -409,27 +1101,56 @@ void does(U16 xt)  {                        ///> metaprogrammer (jump to defindi
 ///
 void variable()
 {
-    create();
-    ENC16(here, 0);                         /// add actual literal storage area
+    if (!_room(6+LIT_SZ+N4_CELL_SZ)) { clear_tib(); return; }
+    if (!_add_word()) return;               /// **fetch token, create name field linked to previous word**
+
+    U16 tmp = IDX(here+2);                  // address to variable storage
+    if (tmp <= LIT_MAX) {                        ///> handle 1-byte address + RET(1)
+        ENC8(here, (U8)tmp);
+    }
+    else {
+        tmp += N4_CELL_SZ;                  ///> or, extra bytes for cell-wide address
+        ENC8(here, PRM_OPS | I_LIT);
+        ENCL(here, tmp);
+    }
+    ENC8(here, PRM_OPS | I_RET);
+    ENCC(here, 0);                          /// add actual literal storage area
 }
 ///
 ///> create a constant on dictionary
 /// * note: 8 or 10-byte per variable
 ///
-void constant(S16 v)
+void constant(DS v)
 {
-    _add_word();                            /// **fetch token, create name field linked to previous word**
+    if (!_room(6+LIT_SZ)) { clear_tib(); return; }
+    if (!_add_word()) return;               /// **fetch token, create name field linked to previous word**
 
-    if (v < 128) {                          ///> handle 1-byte constant
-        ENC8(here, (U8)v);
-    }
-    else {
-        ENC8(here, PRM_OPS | I_LIT);        ///> or, constant stored as 3-byte literal 
-        ENC16(here, v);
-    }
+    _add_lit((DU)v);                        ///> 1-byte or cell-wide literal (negative too)
     ENC8(here, PRM_OPS | I_RET);
 }
 ///
+///> create a deferred word on dictionary, [UDJ target][RET]
+/// * a call to it costs one extra jump, target is its own RET until IS
+///
+void defer()
+{
+    if (!_room(6+JMP_SZ)) { clear_tib(); return; }
+    if (!_add_word()) return;
+
+    U16 r = IDX(here) + JMP_SZ;             ///< its own RET
+    JMPTO(r, OP_UDJ);                       ///> jump to target, no return address kept
+    ENC8(here, PRM_OPS | I_RET);
+}
+///
+///> point deferred word to xt, by patching its jump
+///
+void is(U16 pfa, U16 xt)
+{
+    U8 *p = DIC(pfa);
+    if ((*p & JMP_MASK)!=OP_UDJ) { show("IS!\n"); return; } /// * not a deferred word
+    JMPSET(pfa, DIC(xt));
+}
+///
 ///> display words in dictionary
 ///
 void words()
@@ -439,7 +1160,7 @@ void words()
     for (U8 *p=last, *ex=DIC(LFA_END); p!=ex; p=DIC(GET16(p))) { /// **from last, loop through dictionary**
         d_chr(n++%wrp ? ' ' : '\n');
         if (trc) { d_adr(IDX(p)); d_chr(':'); }                  ///>> optionally show address
-        d_chr(p[2]); d_chr(p[3]); d_chr(p[4]);                   ///>> 3-char name
+        d_chr(NM(p[2])); d_chr(NM(p[3])); d_chr(NM(p[4]));       ///>> 3-char name
     }
     _list_voc(trc ? n<<1 : n);                                   ///> list built-in vocabularies
     d_chr(' ');
@@ -457,13 +1178,876 @@ void forget()
     U8 *lfa = DIC(xt - 2 - 3);         ///< pointer to word's link
     last    = DIC(GET16(lfa));         /// * reset last word address
     here    = lfa;                     /// * reset current pointer
+    hot_scan();                        /// * free slots of forgotten words
+}
+#if N4_EFF
+///
+///@name Stack Effect Inference
+/// @brief
+///    walks code once from xt to its RET, branch targets and loop heads keep the<br/>
+///    depths they are reached with, paths that meet must agree, callees walked in turn
+///@{
+#if ARDUINO
+constexpr U8 EFF_PT  = 6;                   ///< branch points tracked per word
+constexpr U8 EFF_LVL = 4;                   ///< nested calls walked (C stack is tight)
+#else
+constexpr U8 EFF_PT  = 8;
+constexpr U8 EFF_LVL = 8;
+#endif // ARDUINO
+constexpr S8 EFF_UNK = -128;                ///< loop head not reached yet
+constexpr S8 EFF_LIM = 100;                 ///< depth beyond any real stack
+typedef struct {
+    U16 a;                                  ///< code address
+    S8  d, r;                               ///< data, return stack depth when reached
+    U8  hd;                                 ///< loop head, kept for backward branches
+} EffPt;
+///@}
+///
+///> record depths at branch target w, or check them against the ones recorded
+/// @return 1: ok, 0: paths disagree or out of points
+///
+U8 _eff_to(EffPt *pt, U8 *np, U16 w, S8 d, S8 r)
+{
+    for (U8 i=0; i<*np; i++) {
+        if (pt[i].a!=w) continue;
+        if (pt[i].d==EFF_UNK) return 0;     /// * head jumped to before reached
+        return pt[i].d==d && pt[i].r==r;
+    }
+    if (*np==EFF_PT) return 0;
+    EffPt *x = &pt[(*np)++];
+    x->a = w; x->d = d; x->r = r; x->hd = 0;
+    return 1;
+}
+///
+///> walk code at xt, lvl: call depth
+///
+U8 _eff(U16 xt, EffRec *e, U8 lvl)
+{
+    #define EFF_IO(i,o) { d -= (i); if (d < lo) lo = d; if (mr && d < lm) lm = d; d += (o); if (d > hi) hi = d; }
+    #define EFF_CALL(k) {                                   \
+        if (d - c.in < lo) lo = d - c.in;                   \
+        if (mr && d - c.need < lm) lm = d - c.need;         \
+        if (d + c.dmax > hi) hi = d + c.dmax;               \
+        if (r + (k) + c.rmax > rh) rh = r + (k) + c.rmax;   \
+        d += c.net;                                         \
+    }
+    #define EFF_R(n)    { r += (n); if (r > rh) rh = r; if (r < 0) return 0; }
+    if (lvl > EFF_LVL) return 0;            /// * too deep, or recursive
+    EffPt pt[EFF_PT];
+    U8  np = 0;
+    U8  *p;
+    for (p=DIC(xt); *p!=(PRM_OPS|I_RET) && *p!=(PRM_OPS|I_DO); p+=_eff_sz(p)) {
+        U8 lp = *p==(PRM_OPS|I_EXT) && (p[1]==X_LOOP || p[1]==X_PLOOP);
+        U8 op = lp ? p[EXT_SZ] : *p;        ///> pass 1, loop heads
+        if ((op & CTL_BITS)!=JMP_OPS || (op & JMP_MASK)==OP_CALL) continue;
+        U16 w = JADR(lp ? p+EXT_SZ : p);
+        if (w > IDX(p)) continue;           /// * forward branch
+        if (np==EFF_PT) return 0;
+        pt[np].a = w; pt[np].d = EFF_UNK; pt[np].r = 0; pt[np++].hd = 1;
+    }
+    U16 end = IDX(p);                       ///< RET (or DO>)
+    U16 lv[4];                              ///< exits of DO loops open
+    U8  nl = 0, live = 1, mr;
+    S8  d = 0, r = 0, lo = 0, lm = 0, hi = 0, rh = 0;
+    EffRec c;
+    for (p=DIC(xt); ; p+=_eff_sz(p)) {
+        U16 a = IDX(p);
+        for (U8 i=0; i<np; ) {              ///> pass 2, merge paths reaching a
+            EffPt *x = &pt[i];
+            if (x->a!=a || x->d==EFF_UNK) { i++; continue; }
+            if (!live) { d = x->d; r = x->r; live = 1; }
+            else if (x->d!=d || x->r!=r) return 0;
+            if (x->hd) i++;
+            else *x = pt[--np];             /// * forward target passed, free it
+        }
+        for (U8 i=0; i<np; i++) {           /// * loop head, entered from above
+            EffPt *x = &pt[i];
+            if (x->a!=a || x->d!=EFF_UNK) continue;
+            if (!live) return 0;
+            x->d = d; x->r = r;
+        }
+        if (a==end) break;
+        if (!live) continue;                /// * not reachable
+        mr = 1;                             /// * must run, no forward branch pending over it
+        for (U8 i=0; i<np; i++) if (!pt[i].hd) mr = 0;
+        U8 op = *p;
+        if ((op & CTL_BITS)==JMP_OPS) {     ///> branch
+            U16 w = JADR(p);
+            switch (op & JMP_MASK) {
+            case OP_CALL:
+                if (!_eff(w, &c, lvl+1)) return 0;
+                EFF_CALL(1);
+                break;
+            case OP_CDJ: EFF_IO(1, 0);      /* fall through */
+            case OP_UDJ:
+                if ((op & JMP_MASK)==OP_UDJ && (w < xt || w > end)) {
+                    if (!_eff(w, &c, lvl+1)) return 0;  /// * tail call, its RET is ours
+                    EFF_CALL(0);
+                    w  = end;
+                }
+                if (w < xt || w > end || !_eff_to(pt, &np, w, d, r)) return 0;
+                if ((op & JMP_MASK)==OP_UDJ) live = 0;
+                break;
+            case OP_NXT:
+                if (!_eff_to(pt, &np, w, d, r)) return 0;
+                EFF_R(-1);                  /// * counter dropped on exit
+                break;
+            }
+        }
+        else if ((op & CTL_BITS)==PRM_OPS) {///> primitive
+            op &= PRM_MASK;
+            U8 x = p[1];
+            switch (op) {
+            case I_LIT: EFF_IO(0, 1); break;
+            case I_EXT: {
+                if (x < X_DO) {             /// * EXT word
+                    U8 v = pgm_read_byte(EXT_EFF + x);
+                    EFF_IO(v>>4, v&0xf);
+                    break;
+                }
+                U16 w = JADR(p+EXT_SZ);     ///< branch following DO LOP +LP CAS DOES
+                switch (x) {
+                case X_DO:
+                    EFF_IO(2, 0); EFF_R(3);
+                    if (nl==4 || !_eff_to(pt, &np, w, d, r-3)) return 0;
+                    lv[nl++] = w;
+                    break;
+                case X_PLOOP: EFF_IO(1, 0); /* fall through */
+                case X_LOOP:
+                    if (!nl || !_eff_to(pt, &np, w, d, r)) return 0;
+                    EFF_R(-3); nl--;
+                    break;
+                case X_LEAVE:
+                    if (!nl || !_eff_to(pt, &np, lv[nl-1], d, r-3)) return 0;
+                    live = 0;
+                    break;
+                case X_CAS: {               /// * bodies get the selector dropped
+                    U8  *t = DIC(w);
+                    U16 df = GET16(t+4);
+                    U8  n  = t[3], sz = t[1]==X_JTB ? 2 : N4_CELL_SZ + 2;
+                    U8  *q = t + X_TBL_HDR + (t[1]==X_JTB ? N4_CELL_SZ : 0);
+                    if (!_eff_to(pt, &np, df, d, r)) return 0;
+                    EFF_IO(1, 0);
+                    for (; n; n--, q+=sz) {
+                        U16 b = GET16(q + sz - 2);
+                        if (b!=df && !_eff_to(pt, &np, b, d, r)) return 0;
+                    }
+                    live = 0;
+                } break;
+                case X_IS: EFF_IO(2, 0); break;
+                case X_DOES:                /// * data field, then DO> code as a tail
+                    EFF_IO(0, 1);
+                    if (w==a + X_LOOP_SZ) break;
+                    if (!_eff(w, &c, lvl+1)) return 0;
+                    EFF_CALL(0);            /// * its RET returns for us
+                    break;
+                }                           /// * JTB, CHN skipped as code
+            } break;
+            case I_LCL: {
+                U8 n = x & LCL_MASK;
+                switch (x & ~LCL_MASK) {
+                case LCL_GET: EFF_IO(0, 1); break;
+                case LCL_SET: EFF_IO(1, 0); break;
+                case LCL_ENT: EFF_IO(n, 0); EFF_R(n); break;
+                case LCL_END: EFF_R(-(S8)n); break;
+                }
+            } break;
+            case 31: EFF_IO(1, 0); EFF_R(1);  break;    /// * >R
+            case 32: EFF_IO(0, 1); EFF_R(-1); break;    /// * R>
+            case I_FOR: EFF_IO(1, 0); EFF_R(1); break;
+            default: {
+                U8 v = pgm_read_byte(PRM_EFF + op);
+                if (v==0xff) return 0;      /// * EXE, API
+                EFF_IO(v>>4, v&0xf);
+            }
+            }
+        }
+#if N4_DENSE
+        else if (op >= OP_HOT) {            ///> hot call
+            if (!_eff(hot[op - OP_HOT], &c, lvl+1)) return 0;
+            EFF_CALL(1);
+        }
+#endif // N4_DENSE
+        else EFF_IO(0, 1);                  ///> number
+        if (lo < -EFF_LIM || hi > EFF_LIM || rh > EFF_LIM) return 0;
+    }
+    if (!live) return 0;                    /// * RET never reached
+    e->in   = -lo;
+    e->need = -lm;
+    e->net  = d;
+    e->dmax = hi;
+    e->rmax = rh;
+    return 1;
+    #undef EFF_IO
+    #undef EFF_CALL
+    #undef EFF_R
+}
+///
+///> infer stack effect of code at xt
+///
+U8 effect(U16 xt, EffRec *e) { return _eff(xt, e, 0); }
+///
+///> display stack effect of code at xt, ( in -- out ) and stack peaks
+///
+void _d_eff(U16 xt)
+{
+    EffRec e;
+    if (!effect(xt, &e)) { show("( ? ) "); return; }
+    show("( "); d_num(e.in); show(" -- "); d_num(e.in + e.net);
+    show(" ) d"); d_num(e.dmax); show(" r"); d_num(e.rmax); d_chr(' ');
+}
+#endif // N4_EFF
+#if N4_WCT
+///
+///@name Execution Time Estimate
+/// @brief
+///    walks code like see() does, adding up AVR cycles per opcode (host builds use<br/>
+///    the same table, so the estimate holds for the board), FOR and DO loops are<br/>
+///    bounded when their counts are literals, BGN loops and EXE, KEY, API are not
+///@{
+#if ARDUINO
+constexpr U8  WC_LVL  = 4;                  ///< nested calls walked (C stack is tight)
+#else
+constexpr U8  WC_LVL  = 8;
+#endif // ARDUINO
+constexpr U8  WC_CALL = 40;                 ///< CALL, return address pushed, ISR polled
+constexpr U8  WC_RET  = 28;
+constexpr U8  WC_CDJ  = 32;
+constexpr U8  WC_UDJ  = 20;
+constexpr U8  WC_NXT  = 40;
+constexpr U8  WC_DO   = 64;
+constexpr U8  WC_LOP  = 72;                 ///< LOP, +LP
+constexpr U8  WC_NUM  = 24;                 ///< 1-byte literal
+constexpr U8  WC_CHR  = 96;                 ///< per byte of ." output, buffered
+///@}
+///
+///> cycles per opcode in units of 8, dispatch included, 0xff: unbounded
+///
+PROGMEM const U8 PRM_CYC[] = {
+      3,   4,   4,   5,   5,   7,   5,   5,   8,  33, // NOP DRP DUP SWP OVR ROT + - * /
+     33,   4,   5,   5,   5,   4,  10,  10,   6,   6, // MOD NEG AND OR XOR NOT LSH RSH = <
+      6,   6,   6,   7,   5,   6, 255,  15,  15, 100, // > <> @ ! C@ C! KEY EMT CR .
+      5,   5,   5,   4, 125,   8,   4,  13,  10,  10, // ." >R R> HRE RND ALO TRC CLK D+ D-
+      8,   5,   6,   6, 255,  13, 225,  13,  15,  13, // DNG ABS MAX MIN DLY IN AIN OUT PWM PIN
+      8,   8, 255, 255,   8,   7, 255, 255,  13,   0, // TME PCE API CRE , C, ' EXE DO> EXT
+      6,   5,   5,   5                                // LCL I FOR LIT
+};
+PROGMEM const U8 EXT_CYC[] = {
+     10,  13,  88,  50,  50,  13,  63,  13,   7,  18, // UM* M* UM/ */ */M Q* Q/ F* S+ LRP
+     25, 255, 255, 255, 255, 255, 255, 255,  10       // TBL MOV FIL CMP SUM AMN AMX DOT CB!
+};
+///
+///> saturating sum of cycle counts
+///
+U32 _wc_add(U32 a, U32 b) { return (a==WC_INF || b==WC_INF || a+b < a) ? WC_INF : a+b; }
+///
+///> saturating product, n passes through a loop body
+///
+U32 _wc_mul(U32 a, U32 n) { return (a && (a==WC_INF || n > WC_INF/a)) ? WC_INF : a*n; }
+U8  _wc_word(U16 xt, U32 *lo, U32 *hi, U8 lvl);
+///
+///> find a branch in [a, e) jumping to w, of kind k (OP_CDJ, OP_UDJ, OP_NXT)
+/// @return its address, LFA_END if none
+///
+U16 _wc_find(U16 a, U16 e, U16 w, U8 k)
+{
+    for (U8 *p=DIC(a); IDX(p) < e; p+=_eff_sz(p)) {
+        if ((*p & CTL_BITS)==JMP_OPS && (*p & JMP_MASK)==k && JADR(p)==w) return IDX(p);
+    }
+    return LFA_END;
 }
 ///
+///> best, worst cycles of structured code in [a, e)
+/// @return 1: ok, 0: not structured as the compiler lays it out
+///
+U8 _wc(U16 a, U16 e, U32 *lo, U32 *hi, U8 lvl)
+{
+    #define WC(l,h)  { *lo = _wc_add(*lo, (l)); *hi = _wc_add(*hi, (h)); }
+    U8  *p, *p0 = NULL, *p1 = NULL, *p2;    ///< this, last two instructions, for literal counts
+    U32 l1, h1, l2, h2;
+    *lo = *hi = 0;
+    for (p=DIC(a); IDX(p) < e; ) {
+        p2 = p1; p1 = p0; p0 = p;
+        U16 x = IDX(p);
+        U16 b = _wc_find(x + 1, e, x, OP_UDJ);  ///> BGN...WHL...RPT, never bounded
+        if (b!=LFA_END) {
+            U16 t = _wc_find(x, b, b + JMP_SZ, OP_CDJ);
+            if (t==LFA_END || !_wc(x, t, &l1, &h1, lvl)) return 0;
+            WC(l1 + WC_CDJ, WC_INF);
+            p = DIC(b + JMP_SZ);
+            continue;
+        }
+        b = _wc_find(x + 1, e, x, OP_CDJ);  ///> BGN...UTL
+        if (b!=LFA_END) {
+            if (!_wc(x, b, &l1, &h1, lvl)) return 0;
+            WC(l1 + WC_CDJ, WC_INF);
+            p = DIC(b + JMP_SZ);
+            continue;
+        }
+        U8 op = *p;
+        DS v;
+        if ((op & CTL_BITS)==JMP_OPS) {     ///> branch
+            U16 w = JADR(p);
+            switch (op & JMP_MASK) {
+            case OP_CALL:
+                if (!_wc_word(w, &l1, &h1, lvl+1)) return 0;
+                WC(l1 + WC_CALL, h1==WC_INF ? WC_INF : h1 + WC_CALL);
+                break;
+            case OP_CDJ: {                  /// * IF...THN, IF...ELS...THN
+                if (w <= x || w > e) return 0;
+                U8 *q, *q1 = p;
+                for (q=p+JMP_SZ; IDX(q) < w; q1=q, q+=_eff_sz(q));
+                U16 u = (*q1 & CTL_BITS)==JMP_OPS && (*q1 & JMP_MASK)==OP_UDJ
+                    ? JADR(q1) : LFA_END;
+                if (u!=LFA_END && u >= w && u <= e) {
+                    if (!_wc(x + JMP_SZ, IDX(q1), &l1, &h1, lvl) ||
+                        !_wc(w, u, &l2, &h2, lvl)) return 0;
+                    l1 += WC_UDJ; h1 = _wc_add(h1, WC_UDJ);
+                    WC(WC_CDJ + (l1 < l2 ? l1 : l2), _wc_add(WC_CDJ, h1 > h2 ? h1 : h2));
+                    p = DIC(u);
+                }
+                else {
+                    if (!_wc(x + JMP_SZ, w, &l1, &h1, lvl)) return 0;
+                    WC(WC_CDJ, _wc_add(WC_CDJ, h1));
+                    p = DIC(w);
+                }
+            } continue;
+            case OP_UDJ:                    /// * skip over padding, or a tail call (DEF, OPT)
+                if (w > x && w <= e) { WC(WC_UDJ, WC_UDJ); p = DIC(w); continue; }
+                if (!_wc_word(w, &l1, &h1, lvl+1)) return 0;
+                WC(l1 + WC_UDJ, _wc_add(h1, WC_UDJ));
+                p = DIC(e);
+                continue;
+            default: return 0;              /// * stray NXT
+            }
+            p += JMP_SZ;
+            continue;
+        }
+        if ((op & CTL_BITS)!=PRM_OPS) {     ///> number, or hot call
+#if N4_DENSE
+            if (op >= OP_HOT) {
+                if (!_wc_word(hot[op - OP_HOT], &l1, &h1, lvl+1)) return 0;
+                WC(l1 + WC_CALL, h1==WC_INF ? WC_INF : h1 + WC_CALL);
+            }
+            else
+#endif // N4_DENSE
+            WC(WC_NUM, WC_NUM);
+            p += _op_sz(p);
+            continue;
+        }
+        op &= PRM_MASK;                     ///> primitive
+        U8 xo = p[1];
+        if (op==I_RET || op==I_DO) break;   /// * end of word, or of defining part
+        if (op==I_FOR) {                    ///> FOR...NXT, runs n times
+            U16 n = _wc_find(x + 1, e, x + 1, OP_NXT);
+            if (n==LFA_END || !_wc(x + 1, n, &l1, &h1, lvl)) return 0;
+            l1 += WC_NXT; h1 = _wc_add(h1, WC_NXT);
+            U32 c = (p1 && _lit_at(p1, &v, 1)) ? (U32)(DU)v : 0;   /// * 0 wraps, not bounded
+            WC(8 * pgm_read_byte(PRM_CYC + I_FOR) + (c ? _wc_mul(l1, c) : l1),
+               c ? _wc_add(8 * pgm_read_byte(PRM_CYC + I_FOR), _wc_mul(h1, c)) : WC_INF);
+            p = DIC(n + JMP_SZ);
+            continue;
+        }
+        if (op==I_EXT && xo==X_DO) {        ///> DO...LOP, runs limit-start times
+            U16 w = JADR(p + EXT_SZ);       ///< loop exit
+            U8  *q = DIC(w - X_LOOP_SZ);    ///< LOP, +LP
+            DS  s, m;
+            if (!_wc(x + X_LOOP_SZ, IDX(q), &l1, &h1, lvl)) return 0;
+            l1 += WC_LOP; h1 = _wc_add(h1, WC_LOP);
+            U32 c = (q[1]==X_LOOP && p2 && _lit_at(p1, &s, 1) && _lit_at(p2, &m, 1) && m > s)
+                ? (U32)(m - s) : 0;
+            U8  lv = 0;                     ///< LVE may cut it to one pass
+            for (U8 *r=DIC(x + X_LOOP_SZ); r < q; r+=_eff_sz(r)) {
+                if (*r==(PRM_OPS|I_EXT) && r[1]==X_LEAVE) lv = 1;
+            }
+            WC(WC_DO + (c && !lv ? _wc_mul(l1, c) : l1), c ? _wc_add(WC_DO, _wc_mul(h1, c)) : WC_INF);
+            p = DIC(w);
+            continue;
+        }
+        if (op==I_EXT && xo==X_CAS) {       ///> CAS...OF...EOF...ECS, one body runs
+            U8  *t = DIC(JADR(p + EXT_SZ));
+            U16 xe = IDX(t) + _op_sz(t);    ///< exit, past the table
+            U16 df = GET16(t + 4);
+            U8  n  = t[3], sz = t[1]==X_JTB ? 2 : N4_CELL_SZ + 2;
+            U8  *q = t + X_TBL_HDR + (t[1]==X_JTB ? N4_CELL_SZ : 0);
+            U32 lb = WC_INF, hb = 0;
+            if (!_wc(df, IDX(t), &lb, &hb, lvl)) return 0;
+            for (; n; n--, q+=sz) {
+                U16 bb = GET16(q + sz - 2);
+                if (bb==df) continue;
+                U16 j  = _wc_find(bb, IDX(t), xe, OP_UDJ);
+                if (j==LFA_END || !_wc(bb, j, &l1, &h1, lvl)) return 0;
+                if (l1 + WC_UDJ < lb) lb = l1 + WC_UDJ;
+                h1 = _wc_add(h1, WC_UDJ);
+                if (h1 > hb) hb = h1;
+            }
+            U32 d = t[1]==X_JTB ? 8 * 8 : _wc_add(5 * 8, _wc_mul(4 * 8, t[3]));
+            WC(5 * 8 + lb, _wc_add(d, hb));
+            p = DIC(xe);
+            continue;
+        }
+        U32 c;
+        switch (op) {
+        case I_EXT:
+            c = xo < X_DO ? pgm_read_byte(EXT_CYC + xo) : (xo==X_LEAVE ? 5 : 8);
+            if (xo==X_DOES) {               /// * DO> code runs as a tail
+                if (!_wc_word(JADR(p + EXT_SZ), &l1, &h1, lvl+1)) return 0;
+                WC(l1, h1);
+            }
+            break;
+        case I_DQ: c = 0; WC(40 + WC_CHR * xo, 40 + WC_CHR * xo); break;
+        case 44:                            /// * DLY, bounded by a literal
+            c = (p1 && _lit_at(p1, &v, 1)) ? 0 : 0xff;
+            if (!c) WC((U32)(DU)v * WC_MS, (U32)(DU)v * WC_MS);
+            break;
+        default: c = pgm_read_byte(PRM_CYC + op);
+        }
+        if (c==0xff) WC(0, WC_INF)
+        else if (c) WC(8 * c, 8 * c);
+        p += _eff_sz(p);
+    }
+    return 1;
+    #undef WC
+}
+///
+///> best, worst cycles of word at xt, RET included
+///
+U8 _wc_word(U16 xt, U32 *lo, U32 *hi, U8 lvl)
+{
+    if (lvl > WC_LVL) return 0;             /// * too deep, or recursive
+    U8 *p = DIC(xt);
+    while (*p!=(PRM_OPS|I_RET) && *p!=(PRM_OPS|I_DO)) p += _eff_sz(p);
+    if (!_wc(xt, IDX(p), lo, hi, lvl)) return 0;
+    *lo += WC_RET;
+    *hi  = _wc_add(*hi, WC_RET);
+    return 1;
+}
+///
+///> best and worst case cycles of code at xt
+/// @return 1: ok, 0: not analyzable (recursive, or unstructured)
+///
+U8 wcet(U16 xt, U32 *lo, U32 *hi) { return _wc_word(xt, lo, hi, 0); }
+///
+///> display a cycle count, decimal
+///
+void _d_cyc(U32 v)
+{
+    char buf[11], *p = &buf[sizeof(buf)-1];
+    *p = 0;
+    do { *--p = '0' + v % 10; v /= 10; } while (v);
+    show(p);
+}
+///
+///> WCT: display best and worst case cycles of a word
+///
+void wcet()
+{
+    U32 lo, hi;
+    U16 xt = query();
+    if (!xt) return;
+    if (!wcet(xt, &lo, &hi)) { show("?\n"); return; }
+    _d_cyc(lo); show("..");
+    if (hi==WC_INF) d_chr('?');
+    else _d_cyc(hi);
+    show(" cycles\n");
+}
+#endif // N4_WCT
+#if N4_OPT
+///
+///@name Profile-Guided Rewrite
+/// @brief
+///    OPT rewrites the words called most (all words when N4_PROF is 0) in place,<br/>
+///    code keeps its size so no address moves: calls to tiny words are replaced by<br/>
+///    their bodies, calls before RET become jumps, literal arithmetic is folded,<br/>
+///    bytes freed are jumped over (a lone byte can't be, that rewrite is passed),<br/>
+///    a jump never lands first in a word, where it would read as a DEF word (see is)<br/>
+///    words are never moved or re-encoded, saved images stay valid as they are
+///@{
+constexpr U8 OPT_TG = 16;                   ///< branch targets tracked per word
+///@}
+///
+///> fill n bytes at p with a jump over them, or an empty ." (code has no 1-byte NOP)
+/// @brief
+///    bytes jumped over become 1-byte literals, code walkers read the word straight<br/>
+///    through and must not meet pieces of the old instructions (a stray RET or LIT)
+///
+void _pad(U8 *p, U8 n)
+{
+    if (!n) return;
+    if (n < JMP_SZ) { p[0] = PRM_OPS | I_DQ; p[1] = 0; return; }
+    U8 *h = here;
+    here = p;
+    JMPTO(IDX(p + n), OP_UDJ);
+    here = h;
+    memset(p + JMP_SZ, 0, n - JMP_SZ);
+}
+///
+///> whether code at xt leaves the return stack alone (>R R> I locals, DO>)
+///
+U8 _rp_free(U16 xt)
+{
+    for (U8 *p=DIC(xt); *p!=(PRM_OPS|I_RET); p+=_eff_sz(p)) {
+        if ((*p & CTL_BITS)!=PRM_OPS) continue;
+        U8 op = *p & PRM_MASK;
+        if (op==31 || op==32 || op==I_I || op==I_LCL || op==I_DO) return 0;
+    }
+    return 1;
+}
+///
+///> size of the body of word at xt, when it fits in n bytes of straight code
+/// @return body size, -1: does not fit, branches, or uses the return stack
+///
+S8 _tiny(U16 xt, U8 n)
+{
+    U8 *p = DIC(xt), *q;
+    for (q=p; *q!=(PRM_OPS|I_RET); q+=_op_sz(q)) {
+        U8 op = *q;
+        if ((op & CTL_BITS)==JMP_OPS || (U16)(q - p) >= n) return -1;
+#if N4_DENSE
+        if (op >= OP_HOT && op < PRM_OPS) return -1;
+#endif // N4_DENSE
+        if ((op & CTL_BITS)!=PRM_OPS) continue;
+        op &= PRM_MASK;
+        if (op==31 || op==32 || op==I_I || op==I_LCL || op==I_FOR ||
+            op==I_DO || (op==I_EXT && q[1]>=X_DO)) return -1;
+    }
+    return (U16)(q - p) <= n ? (S8)(q - p) : -1;
+}
+///
+///> a op b, for the primitives OPT folds
+/// @return 1: folded, 0: not a foldable op
+///
+U8 _fold(U8 op, DS *a, DS b)
+{
+    switch (op) {
+    case 6:  *a += b;                break;   // +
+    case 7:  *a -= b;                break;   // -
+    case 8:  *a *= b;                break;   // *
+    case 12: *a &= b;                break;   // AND
+    case 13: *a |= b;                break;   // OR
+    case 14: *a ^= b;                break;   // XOR
+    case 16: *a <<= b;               break;   // LSH
+    case 17: *a >>= b;               break;   // RSH
+    case 18: *a = b==*a;             break;   // =
+    case 19: *a = b> *a;             break;   // <
+    case 20: *a = b< *a;             break;   // >
+    case 21: *a = b!=*a;             break;   // <>
+    case 42: if (b > *a) *a = b;     break;   // MAX
+    case 43: if (b < *a) *a = b;     break;   // MIN
+    default: return 0;
+    }
+    return 1;
+}
+///
+///> step over padding, empty ." and forward jumps (branches landing in a fold are checked apart)
+///
+U8 *_skip(U8 *p, U8 *e)
+{
+    while (p < e) {
+        if (*p==(PRM_OPS|I_DQ) && !p[1]) { p += 2; continue; }
+        if ((*p & CTL_BITS)!=JMP_OPS || (*p & JMP_MASK)!=OP_UDJ) break;
+        U8 *w = DIC(JADR(p));
+        if (w <= p || w > e) break;
+        p = w;
+    }
+    return p;
+}
+///
+///> rewrite colon word at xt in place
+/// @return number of rewrites
+///
+U16 _opt(U16 xt)
+{
+    U8  *p = DIC(xt), *e, *q;
+    if ((*p & JMP_MASK)==OP_UDJ) return 0;                   /// * DEF word
+    if (*p==(PRM_OPS|I_EXT) && p[1]==X_DOES) return 0;      /// * CREated word
+    U16 tg[OPT_TG];                         ///< branch targets, folds stay clear of them
+    U8  nt = 0, ok = 1;
+    for (e=p; *e!=(PRM_OPS|I_RET); e+=_eff_sz(e)) {
+        U8 op = *e;
+        if (op==(PRM_OPS|I_DO)) return 0;   /// * defining word, DO> code is jumped into
+        U8 *j = NULL;
+        if ((op & CTL_BITS)==JMP_OPS && (op & JMP_MASK)!=OP_CALL) j = e;
+        if (op==(PRM_OPS|I_EXT) && e[1]>=X_DO && e[1]<X_JTB &&
+            e[1]!=X_LEAVE && e[1]!=X_IS) j = e + EXT_SZ;
+        if (j) { if (nt < OPT_TG) tg[nt++] = JADR(j); else ok = 0; }
+        if (op==(PRM_OPS|I_EXT) && e[1]>=X_JTB) {   /// * CAS table, bodies and default
+            U8 n = e[3], sz = e[1]==X_JTB ? 2 : N4_CELL_SZ + 2;
+            U8 *t = e + X_TBL_HDR + (e[1]==X_JTB ? N4_CELL_SZ : 0);
+            if (nt + n + 1 > OPT_TG) ok = 0;
+            else {
+                tg[nt++] = GET16(e + 4);
+                for (; n; n--, t+=sz) tg[nt++] = GET16(t + sz - 2);
+            }
+        }
+    }
+    U16 n = 0;
+    for (q=p; q < e; q+=_eff_sz(q)) {       ///> calls, inline tiny words or jump at tail
+        U8  op = *q;
+        U16 w;
+        U8  sz;
+        if ((op & CTL_BITS)==JMP_OPS && (op & JMP_MASK)==OP_CALL) { w = JADR(q); sz = JMP_SZ; }
+#if N4_DENSE
+        else if (op >= OP_HOT && op < PRM_OPS) { w = hot[op - OP_HOT]; sz = 1; }
+#endif // N4_DENSE
+        else continue;
+        S8 b = _tiny(w, sz);
+        if (b >= 0 && sz - b != 1 && (b || q!=p)) {
+            memcpy(q, DIC(w), b);
+            _pad(q + b, sz - b);
+            n++;
+        }
+        else if (q!=p && q + sz==e && sz==JMP_SZ && _rp_free(w)) {
+            *q = (op & ~JMP_MASK) | OP_UDJ; /// * tail call, no return address kept
+            n++;
+        }
+    }
+    if (!ok) return n;
+    for (U16 n0=LFA_END; n0!=n; ) {         ///> literal arithmetic, a b op => c, till settled
+        n0 = n;
+        for (q=p; q < e; q+=_eff_sz(q)) {
+            DS  v, b;
+            U8  s = _num(q, &v), f = 0;
+            if (!s) continue;
+            U8  *r = q + s;
+            for (;;) {
+                U8 *a = _skip(r, e), *o;
+                U8 s2 = a < e ? _num(a, &b) : 0;
+                if (!s2) break;
+                o = _skip(a + s2, e);
+                if (o >= e || (*o & CTL_BITS)!=PRM_OPS) break;
+                U8 i = 0;
+                while (i < nt && !(tg[i] > IDX(q) && tg[i] <= IDX(o))) i++;
+                if (i < nt) break;              /// * a branch lands inside
+                DS c = v;
+                if (!_fold(*o & PRM_MASK, &c, b)) break;
+                v = c; r = o + 1; f = 1;
+            }
+            if (!f) continue;
+            U8 buf[OPS_MAX], *h = here;         ///> encode the result, shortest form
+            here = buf;
+            _add_lit((DU)v);
+            U8 m = (U8)(here - buf);
+            here = h;
+            if (m > (U8)(r - q) || (U8)(r - q) - m==1) continue;
+            memcpy(q, buf, m);
+            _pad(q + m, (U8)(r - q) - m);
+            n++;
+        }
+    }
+    return n;
+}
+///
+///> OPT: rewrite the words with most calls counted, then start counting anew
+///
+void optimize()
+{
+    U16 n = 0;
+#if N4_PROF
+    U16 mx = 0;
+    for (U8 i=0; i<PROF_SZ; i++) if (prof[i] > mx) mx = prof[i];
+#endif // N4_PROF
+    for (U8 *w=last, *ex=DIC(LFA_END); w!=ex; w=DIC(GET16(w))) {
+        U16 xt = IDX(w) + 2 + 3;
+#if N4_PROF
+        U16 c = prof[PROF_IX(xt)];
+        if (!c || c < (mx >> 3)) continue;  /// * cold, under 1/8 of the hottest
+#endif // N4_PROF
+        n += _opt(xt);
+    }
+#if N4_PROF
+    memset(prof, 0, sizeof(prof));
+#endif // N4_PROF
+    d_num(n); show(" rewritten\n");
+}
+#endif // N4_OPT
+#if N4_AOT
+///
+///@name Ahead-of-Time Translation
+/// @brief
+///    n4 -c writes a C++ function per colon word, calling the primitives of _invoke,<br/>
+///    branches become gotos, FOR...NXT counts on the return stack as _nest does, words<br/>
+///    with DO loops, CAS, locals, DO> or calls to themselves are left as bytecode,<br/>
+///    the VM runs the functions while code_sum over their words still matches
+///@{
+///
+///> Fletcher-16 of code at xt till RET, chained from s, operands taken in image byte order
+///
+U16 code_sum(U16 xt, U16 s)
+{
+    U16 s1 = s & 0xff, s2 = s >> 8;
+    for (U8 *p=DIC(xt); p < here && *p!=(PRM_OPS|I_RET); ) {
+        U8 n = _op_sz(p), k = 0;                    ///< k: operand bytes taken from v
+        DU v = 0;
+        if (*p==(PRM_OPS|I_LIT)) { v = (DU)GETL(p+1); k = N4_CELL_SZ; }
+#if N4_WIDE_ADR
+        if ((*p & CTL_BITS)==JMP_OPS) { v = JADR(p); k = 2; }
+#endif // N4_WIDE_ADR
+        for (U8 i=0; i<n; i++) {
+            U8 b = (i && i <= k) ? (U8)(v >> ((k - i) << 3)) : p[i];
+            s1 = (s1 + b)  % 255;
+            s2 = (s2 + s1) % 255;
+        }
+        p += n;
+    }
+    return (s2 << 8) | s1;
+}
+#if !ARDUINO
+///
+///> whether colon word at xt can run as native code
+///
+U8 _aot_ok(U16 xt)
+{
+    U8 *p = DIC(xt), *e;
+    if ((*p & JMP_MASK)==OP_UDJ) return 0;                   /// * DEF word, IS repoints it
+    if (*p==(PRM_OPS|I_EXT) && p[1]==X_DOES) return 0;      /// * CREated word
+    U8 d = 0;                                               ///< cells it put on return stack
+    for (e=p; *e!=(PRM_OPS|I_RET); e+=_op_sz(e)) {
+        U8 op = *e;
+        if ((op & CTL_BITS)==JMP_OPS) {
+            if ((op & JMP_MASK)==OP_CALL && JADR(e)==xt) return 0; /// * recursion takes C stack
+            if ((op & JMP_MASK)==OP_NXT && d) d--;
+            continue;
+        }
+#if N4_DENSE
+        if (op >= OP_HOT && op < PRM_OPS && hot[op - OP_HOT]==xt) return 0;
+#endif // N4_DENSE
+        if ((op & CTL_BITS)!=PRM_OPS) continue;
+        op &= PRM_MASK;
+        if (op==I_EXT || op==I_LCL || op==I_DO) return 0;   /// * DO loops, CAS, locals, DO>
+        if (op==31 || op==I_FOR) d++;                       /// * >R, FOR
+        if ((op==32 || op==I_I) && !d) return 0;            /// * R>, I reaching into the caller
+        if (op==32) d--;
+    }
+    return 1;
+}
+///
+///> end a line with a 3-char name as comment (no backslash, it would continue the line)
+///
+void _aot_nm(FILE *f, const char *nm)
+{
+    fputs(" // ", f);
+    for (U8 i=0; i<3; i++) {
+        char c = NM(nm[i]);
+        fputc((c=='\\' || c < ' ') ? '?' : c, f);
+    }
+    fputc('\n', f);
+}
+///
+///> call to word at w, direct when it is translated too
+///
+void _aot_call(FILE *f, U16 w)
+{
+    if (_aot_ok(w)) fprintf(f, "    _w%04x();", w);
+    else            fprintf(f, "    N4VM::nest(0x%04x);", w);
+    _aot_nm(f, (const char*)DIC(w) - 3);
+}
+///
+///> function for colon word at xt
+///
+void _aot_word(FILE *f, U16 xt)
+{
+    U8 *p = DIC(xt), *e, *q, *j;
+    for (e=p; *e!=(PRM_OPS|I_RET); e+=_op_sz(e));
+    fprintf(f, "static void _w%04x() {", xt);
+    _aot_nm(f, (const char*)p - 3);
+    for (q=p; q < e; q+=_op_sz(q)) {
+        U16 a = IDX(q);
+        for (j=p; j < e; j+=_op_sz(j)) {            ///> label, when a branch lands here
+            if ((*j & CTL_BITS)==JMP_OPS && (*j & JMP_MASK)!=OP_CALL && JADR(j)==a) break;
+        }
+        if (j < e) fprintf(f, "L%04x:\n", a);
+        U8 op = *q;
+        DS v;
+        if (_num(q, &v)) { fprintf(f, "    PUSH(%ld);\n", (long)v); continue; }
+#if N4_DENSE
+        if (op >= OP_HOT && op < PRM_OPS) { _aot_call(f, hot[op - OP_HOT]); continue; }
+#endif // N4_DENSE
+        if ((op & CTL_BITS)==JMP_OPS) {
+            U16 w = JADR(q);
+            char go[24];                            ///< local branch, back ones serve ISRs
+            if (w==IDX(e)) strcpy(go, "return;");
+            else sprintf(go, w > a ? "goto L%04x;" : "{ N4VM::serv_isr(); goto L%04x; }", w);
+            switch (op & JMP_MASK) {
+            case OP_CALL: _aot_call(f, w);                           break;
+            case OP_CDJ:  fprintf(f, "    if (!POP()) %s\n", go);   break;
+            case OP_UDJ:
+                if (w >= xt && w <= IDX(e)) { fprintf(f, "    %s\n", go); break; }
+                _aot_call(f, w);                    /// * tail call
+                fputs("    return;\n", f);                          break;
+            case OP_NXT:
+                fprintf(f, "    if (--*(vm.rp-1)) %s\n    vm.rp--;\n", go); break;
+            }
+            continue;
+        }
+        op &= PRM_MASK;
+        switch (op) {
+        case I_DQ:  fprintf(f, "    d_str(dic + 0x%04x);\n", a + 1); break;
+        case I_EXE: fputs("    N4VM::call(POP());\n", f);           break;
+        default:
+            fprintf(f, "    N4VM::invoke(%d);", op);
+            _aot_nm(f, op >= I_I ? &PMX[1 + (op - I_I)*3] : &PRM[1 + op*3]);
+        }
+    }
+    fputs("}\n", f);
+}
+///
+///> translate colon words into C++, with n4_native() to register them
+///
+int aot(const char *fname)
+{
+    FILE *f = fopen(fname, "w");
+    if (!f) return -1;
+
+    U16 nw = 0, n = 0, s = 0, i;
+    U8  *w, *ex = DIC(LFA_END);
+    for (w=last; w!=ex; w=DIC(GET16(w))) nw++;
+    U16 *xs = (U16*)malloc((nw + 1) * sizeof(U16)); ///< words, ascending
+    for (i=nw, w=last; w!=ex; w=DIC(GET16(w))) xs[--i] = IDX(w) + 2 + 3;
+
+    fputs("///\n/// nanoForth words translated ahead of time by n4 -c, do not edit\n///\n", f);
+    fputs("#include \"n4_core.h\"\n#include \"n4_vm.h\"\n", f);
+    fprintf(f, "#if N4_CELL_SZ!=%d || N4_WIDE_ADR!=%d || N4_DENSE!=%d || !N4_AOT\n",
+            N4_CELL_SZ, N4_WIDE_ADR, N4_DENSE);
+    fputs("#error \"translated with other N4_CELL_SZ, N4_WIDE_ADR or N4_DENSE\"\n#endif\n", f);
+    fputs("using namespace N4Core;\n", f);
+    fputs("#define PUSH(v)  (*(--vm.sp)=(DS)(v))\n#define POP()    (*vm.sp++)\n", f);
+    fputs("#define RPOP()   (*(--vm.rp))\n\n", f);
+    for (i=0; i<nw; i++) {                          ///> declarations, calls go either way
+        if (!_aot_ok(xs[i])) continue;
+        fprintf(f, "static void _w%04x();", xs[i]);
+        _aot_nm(f, (const char*)DIC(xs[i]) - 3);
+        n++;
+    }
+    for (i=0; i<nw; i++) if (_aot_ok(xs[i])) _aot_word(f, xs[i]);
+    if (n) {
+        fputs("\nstatic const AotRec _aot[] = {\n", f);
+        for (i=0; i<nw; i++) {
+            if (!_aot_ok(xs[i])) continue;
+            fprintf(f, "    { 0x%04x, _w%04x },\n", xs[i], xs[i]);
+            s = code_sum(xs[i], s);
+        }
+        fputs("};\n", f);
+        fprintf(f, "void n4_native() { N4VM::native(_aot, %d, 0x%04x); }\n", n, s);
+    }
+    else fputs("void n4_native() {}\n", f);
+    fclose(f);
+    free(xs);
+    printf("\n%s: %d of %d words\n", fname, n, nw);
+    return 0;
+}
+#endif // !ARDUINO
+///@}
+#endif // N4_AOT
+///
 ///> decode colon word
 ///
 void see()
 {
     U16 xt = query();                  ///< cfa of word
+#if N4_EFF
+    U16 xt0 = xt;
+#endif // N4_EFF
     if (!xt) return;                   /// * bail if word not found
     ///
     /// word found, walk parameter field
@@ -473,6 +2057,24 @@ void see()
         xt = trace(xt, ir, '\n');
     }
     d_adr(xt); show("_; ");
+#if N4_EFF
+    _d_eff(xt0);                       /// * inferred stack effect
+#endif // N4_EFF
+}
+///
+///> display name of word called, indented per call-depth when tracing
+///
+void _d_call(U16 w, char delim)
+{
+    U8 *p = DIC(w)-3;                                 // backtrack 3-byte (name field)
+    d_chr(':');
+    d_chr(NM(p[0])); d_chr(NM(p[1])); d_chr(NM(p[2]));
+    if (!delim) {
+        show("\n....");
+        for (int i=0, n=++tab; i<n; i++) {            // indentation per call-depth
+            show("  ");
+        }
+    }
 }
 ///
 ///> execution tracer (debugger, can be modified into single-stepper)
@@ -483,19 +2085,9 @@ U16 trace(U16 a, U8 ir, char delim)
 
     switch (ir & CTL_BITS) {
     case JMP_OPS: {                                   ///> is a jump instruction?
-        U16 w = GET16(DIC(a)) & ADR_MASK;             // target address
+        U16 w = JADR(DIC(a));                         // target address
         switch (ir & JMP_MASK) {                      // get branching opcode
-        case OP_CALL: {                               // 0xc0 CALL word call
-            U8 *p = DIC(w)-3;                         // backtrack 3-byte (name field)
-            d_chr(':');
-            d_chr(*p++); d_chr(*p++); d_chr(*p);
-            if (!delim) {
-	            show("\n....");
-    	        for (int i=0, n=++tab; i<n; i++) {    // indentation per call-depth
-        	        show("  ");
-	            }
-            }
-        } break;
+        case OP_CALL: _d_call(w, delim);   break;     // 0xc0 CALL word call
         case OP_CDJ: d_chr('?'); d_adr(w); break;     // 0xd0 CDJ  conditional jump
         case OP_UDJ: d_chr('j'); d_adr(w); break;     // 0xe0 UDJ  unconditional jump
         case OP_NXT:                                  // 0xf0 NXT
@@ -503,7 +2095,7 @@ U16 trace(U16 a, U8 ir, char delim)
             else show("_NXT");
             break;
         }
-        a+=2;                                         // skip over address
+        a += JMP_SZ;                                  // skip over address
     } break;
     case PRM_OPS: {                                   ///> is a primitive?
     	ir &= PRM_MASK;                               // capture primitive opcode
@@ -512,12 +2104,12 @@ U16 trace(U16 a, U8 ir, char delim)
         	d_chr('_'); d_chr(';');
             tab -= tab ? 1 : 0;
             break;
-        case I_LIT: {                                 // 3-byte literal (i.e. 16-bit signed integer)
-            U8 *p = DIC(a)+1;                         // address to the 16-bit number
-            S16 w = GET16(p);                         // fetch the number
+        case I_LIT: {                                 // cell-wide literal (i.e. signed integer)
+            U8 *p = DIC(a)+1;                         // address to the number
+            DS w = (DS)GETL(p);                       // fetch the number
             d_chr('#');
             d_num(w);
-            a += 2;                                   // skip literal
+            a += N4_CELL_SZ;                          // skip literal
         } break;
         case I_DQ: {                                  // print string
             U8 *p = DIC(a)+1;                         // address to string header
@@ -525,6 +2117,22 @@ U16 trace(U16 a, U8 ir, char delim)
             d_str(p);                                 // print the string to console
             a += *p;
         } break;
+        case I_EXT: {                                 // extended word or loop control
+            U8 x = *DIC(++a);
+            d_chr('_');
+            if (x >= X_JTB) {                         // CAS table, shown as ECS
+                d_name(20, JMP, 0);
+                a += 1 + *DIC(a+1);
+            }
+            else if (x==X_IS) d_name(21, JMP, 0);    // IS, deferred word address before it
+            else if (x==X_DOES) d_name(I_CRE, PRM, 0); // CREated word, DO> branch follows
+            else if (x & X_DO) d_name(x - X_DO + 13, JMP, 0); // DO LOP +LP LVE CAS, branch follows
+            else d_name(x, EXT, 0);                   // name from EXT list
+        } break;
+        case I_LCL: {                                 // local variable, @! offset or {} frame size
+            U8 v = *DIC(++a);
+            d_chr('_'); d_chr("@!{}"[v>>6]); d_num(v & LCL_MASK);
+        } break;
         default:                                      // other opcodes
             d_chr('_');
             U8 ci = ir >= I_I;                        // loop controller flag
@@ -533,7 +2141,16 @@ U16 trace(U16 a, U8 ir, char delim)
         a++;
     } break;
     default:                                          ///> and a number (i.e. 1-byte literal)
-        d_chr('#'); d_num((S16)ir);
+#if N4_DENSE
+        if (ir >= OP_HOT) { _d_call(hot[ir - OP_HOT], delim); a++; break; }
+        if (ir >= OP_SLIT) {                          // short literal
+            U8 b = *DIC(++a);
+            d_chr('#'); d_num(ir==OP_SLIT ? (DS)b : (DS)b - 256);
+            a++;
+            break;
+        }
+#endif // N4_DENSE
+        d_chr('#'); d_num((DS)ir);
         a++;           
     }
     d_chr(delim ? delim : ' ');
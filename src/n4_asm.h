@@ -6,9 +6,13 @@
  *
  * @code
  *    branching : 11BB oooo oooo oooo            (12-bit absolute address)
+ *    wide mode : 11BB 0000 oooo oooo oooo oooo  (16-bit absolute address, see N4_WIDE_ADR)
  *    primitive : 10cc cccc                      (64 primitives)
  *    3-byte lit: 1011 1111 nnnn nnnn nnnn nnnn  bf xxxx xxxx (16-bit signed integer)
- *    1-byte lit: 0nnn nnnn                      (0..127)
+ *    5-byte lit: bf xxxx xxxx xxxx xxxx         (32-bit cells, see N4_CELL_SZ)
+ *    1-byte lit: 0nnn nnnn                      (0..127, or 0..119 with N4_DENSE)
+ *    short lit : 0111 100s nnnn nnnn            (N4_DENSE, 0..255, or -256..-1 when s=1)
+ *    hot call  : 0111 1kkk                      (N4_DENSE, k=2..7 calls hot-call table slot k-2)
  *    n-byte str: len, byte, byte, ...           (used in print str i.e. .")
  * @endcode
  */
@@ -18,6 +22,8 @@
 
 #define N4_DOES_META  1 /**< enable meta programming */
 #define N4_USE_GOTO   1 /**< use computed goto (use 128 byte RAM, speed up 65ms/100K */
+#define N4_LINE_RUN   1 /**< interpret mode compiles (and caches) each line before running it */
+#define N4_STK_CHECK  1 /**< return stack checked on every push (0: trust stack-effect inference) */
 ///
 /// parser actions enum used by execution and assembler units
 ///
@@ -37,7 +43,13 @@ constexpr U8  JMP_OPS  = 0xc0;   ///< 1100 0000
 constexpr U8  PRM_OPS  = 0x80;   ///< 1000 0000
 constexpr U8  JMP_MASK = 0xf0;   ///< 11nn xxxx, nn - CALL 00, CDJ 01, UDJ 10, NXT 11
 constexpr U8  PRM_MASK = 0x3f;   ///< 00nn nnnn, 6-bit primitive opcodes
+#if N4_WIDE_ADR
+constexpr U16 ADR_MASK = 0xffff; ///< aaaa aaaa aaaa aaaa 16-bit address following branch opcode
+constexpr U8  JMP_SZ   = 3;      ///< branch opcode + 16-bit address
+#else
 constexpr U16 ADR_MASK = 0x0fff; ///< 0000 aaaa aaaa aaaa 12-bit address in 16-bit branching instructions
+constexpr U8  JMP_SZ   = 2;      ///< branch opcode and address share 2 bytes
+#endif // N4_WIDE_ADR
 ///@}
 ///@name Opcode Prefixes
 ///@{
@@ -51,13 +63,94 @@ constexpr U8  OP_NXT   = 0xf0;   ///< 1111 0000
 ///
 enum N4_EXT_OP {                 ///< extended opcode (used by for...nxt loop)
     I_RET  = 0,                  ///< hidden opcode
+    I_DRP  = 1,                  ///< DRP, default branch of CAS drops the selector
     I_DQ   = 30,                 ///< ." handler (adjust, if field name list changed)
+    I_ALO  = 35,                 ///< ALO
+    I_CRE  = 53,                 ///< CRE, first of meta words
+    I_EXE  = 57,                 ///< EXE
     I_DO   = 58,                 ///< DO>
+    I_EXT  = 59,                 ///< EXT prefix, index into EXT list follows
+    I_LCL  = 60,                 ///< local variable access, frame operand follows
     I_I    = 61,                 ///< loop counter
     I_FOR,                       ///< 62
     I_LIT                        ///< 63 = 0x3f 3-byte literal
 };
 constexpr U16 LFA_END = 0xffff;  ///< end of link field
+constexpr U8  LIT_SZ  = 1 + N4_CELL_SZ;                 ///< LIT opcode + cell
+#if N4_DENSE
+constexpr U8  LIT_MAX = 0x77;                           ///< largest 1-byte literal
+constexpr U8  OP_SLIT = 0x78;                           ///< short literal, 0x78 b: b, 0x79 b: b-256
+constexpr U8  OP_HOT  = 0x7a;                           ///< 1-byte call, 0x7a + slot
+constexpr U8  HOT_MAX = 6;                              ///< hot-call table slots
+#else
+constexpr U8  LIT_MAX = 0x7f;                           ///< largest 1-byte literal
+#endif // N4_DENSE
+constexpr U8  EXT_SZ  = 2;                              ///< EXT or LCL prefix + 1-byte operand
+#if N4_PROF
+constexpr U8  PROF_SZ = 16;                             ///< call count buckets
+#define PROF_IX(xt)   (((xt) ^ ((xt) >> 4)) & (PROF_SZ - 1)) /**< bucket of word at xt */
+#endif // N4_PROF
+///
+/// loop control, I_EXT with operand 1000 00kk, DO, LOP, +LP followed by a UDJ branch
+///
+enum N4_LOOP_OP {
+    X_DO = 0x80,                 ///< DO  ( limit start -- ), frame [exit, limit, index], branch to exit
+    X_LOOP,                      ///< LOP, index + 1, branch back to loop body
+    X_PLOOP,                     ///< +LP ( n -- ), index + n, branch back to loop body
+    X_LEAVE,                     ///< LVE, drop frame and go to exit
+    X_CAS,                       ///< CAS ( n -- ), branch through the table its UDJ points to
+    X_IS,                        ///< IS ( xt pfa -- ), point a deferred word to xt
+    X_DOES,                      ///< CREated word, push data field after its RET, branch to DO> code
+    X_JTB,                       ///< jump table  sz cnt dflt(2) base(cell) adr(2)*cnt, skipped as code
+    X_CHN                        ///< value chain sz cnt dflt(2) { val(cell) adr(2) }*cnt, skipped too
+};
+constexpr U8  X_LOOP_SZ = EXT_SZ + JMP_SZ;              ///< DO, LOP, +LP, CAS, DOES size
+constexpr U8  X_TBL_HDR = EXT_SZ + 4;                   ///< table header, prefix + sz cnt dflt
+///
+///@name Local Variable Operands (I_LCL kk nnnnnn, n = offset from rp, or frame size)
+///@{
+constexpr U8  LCL_MAX  = 8;      ///< locals per colon word
+constexpr U8  LCL_GET  = 0x00;   ///< push local *(rp-n)
+constexpr U8  LCL_SET  = 0x40;   ///< pop into local *(rp-n)
+constexpr U8  LCL_ENT  = 0x80;   ///< move n cells from data stack into a frame
+constexpr U8  LCL_END  = 0xc0;   ///< drop frame of n cells
+constexpr U8  LCL_MASK = 0x3f;   ///< offset or size
+///@}
+constexpr U8  OPS_MAX = LIT_SZ > X_LOOP_SZ ? LIT_SZ : X_LOOP_SZ; ///< longest opcode (LIT, or DO/LOP)
+constexpr U8  OPS_X2  = (JMP_SZ > 2 || LIT_SZ > 3) ? 3 : 2; ///< code bytes per 2 chars of source, worst case
+#if N4_WCT
+constexpr U32 WC_INF  = 0xffffffffUL;   ///< WCT, no bound on cycles
+constexpr U32 WC_MS   = 16000;          ///< WCT, AVR cycles per ms (16MHz)
+#endif // N4_WCT
+///
+///@name Dictionary Image and Upload Framing
+///
+/// image  : sig(2) last(2) here(2) dic[0..here-1]  (same layout as EEPROM)
+/// upload : UPL\n STX { len(1) byte[len] sum(2) }... 00
+///@{
+constexpr U16 N4_SIG   = (((U16)'N'<<8)+(U16)(N4_CELL_SZ==2 ? '4' : '8'));  ///< EEPROM signature (4 or 8 nibble cells)
+constexpr U16 N4_AUTO  = N4_SIG | 0x8080;           ///< EEPROM auto-run signature
+constexpr U16 N4_SNAP  = N4_SIG | 0x8000;           ///< EEPROM VM snapshot signature
+constexpr U16 ROM_HDR  = 6;      ///< EEPROM (and image) header size
+constexpr U8  UPL_STX  = 0x02;   ///< start of framed upload stream
+constexpr U8  UPL_FRM  = 0x40;   ///< max bytes per upload frame (fits in AVR Serial RX buffer)
+///@}
+///
+///@name Persistence Backend (default: Arduino EEPROM, or mock EEPROM on host)
+///@{
+typedef U16  (*ROM_SZ)();                        ///< capacity in bytes
+typedef void (*ROM_IO)(U16 idx, U8 *p, U16 sz);  ///< bulk read or write
+///@}
+///
+/// stack effect of a colon word, or compiled line, in cells (see N4Asm::effect)
+///
+typedef struct {
+    S8  in;                      ///< cells taken from data stack, on the deepest path
+    S8  need;                    ///< cells taken on every path, i.e. by code that must run
+    S8  net;                     ///< data stack depth change, i.e. ( in -- in+net )
+    S8  dmax;                    ///< data stack peak above entry depth
+    S8  rmax;                    ///< return stack peak, own return address not counted
+} EffRec;
 ///
 /// Assembler class
 ///
@@ -65,35 +158,106 @@ namespace N4Asm                     // (10-byte header)
 {
     extern U8  *last;               ///< pointer to last word, for debugging
     extern U8  *here;               ///< top of dictionary (exposed to _vm for HRE, ALO opcodes)
+    extern U8  cmode;               ///< compile mode, colon word in progress
+#if N4_DENSE
+    extern U16 hot[HOT_MAX];        ///< hot-call table, xt of word per slot (0: free)
+#endif // N4_DENSE
+#if N4_PROF
+    extern U16 prof[PROF_SZ];       ///< call counts, saturating, cleared by OPT
+#endif // N4_PROF
 
     // EEPROM persistence I/O
     void save(U8 autorun=0);        ///< persist user dictionary to EEPROM
     U16  load(U8 autorun=0);        ///< restore user dictionary from EEPROM
+    U8   set_rom(                   ///< plug in a persistence backend (NULLs restore EEPROM), 1: changed
+        ROM_SZ sz,                  ///< capacity function
+        ROM_IO rd,                  ///< bulk read function
+        ROM_IO wr                   ///< bulk write function
+        );
+    U16  rom_size();                ///< capacity of EEPROM in bytes
+    void rom_read(                  ///< bulk read from EEPROM
+        U16 idx,                    ///< EEPROM offset
+        U8  *p,                     ///< destination memory
+        U16 sz                      ///< number of bytes
+        );
+    void rom_write(                 ///< bulk write into EEPROM (only changed bytes)
+        U16 idx,                    ///< EEPROM offset
+        U8  *p,                     ///< source memory
+        U16 sz                      ///< number of bytes
+        );
 
     U16 reset();                    ///< reset internal pointers (for BYE)
 
+    // dictionary image and binary upload
+    U16  header(                    ///< fill an image header for current dictionary
+        U8 *hdr,                    ///< ROM_HDR-byte buffer to be filled
+        U8 autorun                  ///< 1: mark image as autorun
+        );                          ///< @return number of dictionary bytes in image
+    U16  csum(                      ///< Fletcher-16 checksum of an upload frame
+        U8 *p,                      ///< frame payload
+        U8 sz                       ///< payload length
+        );
+    void upload();                  ///< receive a framed binary image into dictionary
+    void flip();                    ///< swap code operands between native and image byte order
+    void hot_scan();                ///< rebuild hot-call table from name fields (N4_DENSE)
+
     /// Instruction decoder
     N4OP parse(
         U8  *tkn,                   ///< token to be parsed
-        U16 *rst,                   ///< parsed result
+        DU  *rst,                   ///< parsed result
         U8  run                     ///< run mode flag (1: run mode, 0: compile mode)
         );
     /// Forth compiler
-    void compile(
-        U16 *rp0                    ///< memory address to be used as assembler return stack
+    void compile(                   ///< start a colon word (then fed token-by-token)
+        DU *rp0                     ///< memory address to be used as assembler return stack
+        );
+    void compile(                   ///< compile one token into the colon word in progress
+        U8 *tkn                     ///< token to be compiled
+        );
+    U8   line(                      ///< compile rest of input line at here, 1: ok, 0: interpret it
+        DU *rp0                     ///< memory address to be used as assembler return stack
         );
     void variable();                ///< create a variable on dictionary
-    void constant(S16 v);           ///< create a constant on dictionary
+    void constant(DS v);            ///< create a constant on dictionary
+    void defer();                   ///< create a deferred word on dictionary
+    void is(U16 pfa, U16 xt);       ///< point deferred word at pfa to xt
     /// meta compiler
     void create();                  ///< create a word name field
-    void comma(S16 v);              ///< compile a 16-bit value onto dictionary
-    void ccomma(S16 v);             ///< compile a 8-it value onto dictionary
+    void comma(DS v);               ///< compile a cell onto dictionary
+    void ccomma(DS v);              ///< compile a 8-it value onto dictionary
+    void allot(DS n);               ///< reserve n bytes of dictionary (negative gives back)
     void does(U16 xt);              ///< metaprogrammer (jump to definding word DO> section)
     // dictionary, string list scanners
     U16  query();                   ///< get xt of next input token, 0 if not found
     void words();                   ///< display words in dictionary
     void forget();                  ///< forgets word in the dictionary
     void see();                     ///< decode colon word
+#if N4_EFF
+    U8   effect(                    ///< infer stack effect, 1: ok, 0: unknown (EXE, API, unbalanced)
+        U16    xt,                  ///< code to walk, till RET
+        EffRec *e                   ///< inferred effect
+        );
+#endif // N4_EFF
+#if N4_WCT
+    U8   wcet(                      ///< estimate cycles, 1: ok, 0: unknown (recursive, unstructured)
+        U16    xt,                  ///< word to walk, till RET
+        U32    *lo,                 ///< best case
+        U32    *hi                  ///< worst case, WC_INF when a loop is not bounded
+        );
+    void wcet();                    ///< WCT, display best and worst case cycles of a word
+#endif // N4_WCT
+#if N4_OPT
+    void optimize();                ///< OPT, rewrite the most called words in place
+#endif // N4_OPT
+#if N4_AOT
+    U16  code_sum(                  ///< Fletcher-16 of code at xt till RET, operands in image order
+        U16 xt,                     ///< code to walk
+        U16 s                       ///< sum carried from previous words, 0 for the first
+        );
+#if !ARDUINO
+    int  aot(const char *fname);    ///< translate colon words into C++ (host n4 -c), 0: ok
+#endif // !ARDUINO
+#endif // N4_AOT
 
     /// print execution tracing info
     U16 trace(
@@ -5,15 +5,13 @@
  */
 #include "n4_core.h"
 
-#if !ARDUINO
-int  Serial;           				     ///< fake serial interface
-#endif // !ARDUINO
-
 namespace N4Core {
 ///
 ///@name MMU controls
 ///@{
 U8      *dic   { NULL };                       ///< base of dictionary
+U16     msz    { 0 };                          ///< size of dictionary+stacks region
+DU      *rp0   { NULL };                       ///< base of return stack (moves with dictionary)
 N4Task  vm;                                    ///< VM states
 ///@}
 ///@name IO controls
@@ -25,17 +23,80 @@ U8      *_tib  { NULL };                       ///< base of terminal input buffe
 U8      _empty { 1 };                          ///< empty flag for terminal input buffer
 U8      _hex   { 0 };                          ///< numeric radix for display
 U8      _ucase { 0 };                          ///< empty flag for terminal input buffer
+U8      *_tp   { NULL };                       ///< token pointer to input buffer
+U8      *_lp   { NULL };                       ///< line editor pointer to input buffer
+U8      _dq    { 0 };                          ///< dot_string flag
+U8      _nl    { 0 };                          ///< line started flag
+U8      _pmt   { 0 };                          ///< prompt shown flag
+U8      _bol   { 0 };                          ///< no token taken from current line yet
+#if !ARDUINO
+U8      _skp   { 0 };                          ///< dropping rest of a line too long for tib
+#endif // !ARDUINO
+///@}
+///@name Output ring buffer
+///@{
+U8      _obuf[N4_OUT_SZ];                      ///< output ring buffer
+U16     _ohd   { 0 };                          ///< ring head (write index)
+U16     _otl   { 0 };                          ///< ring tail (drain index)
+U8      _onl   { N4_OUT_NL };                  ///< flush policy (drain on newline)
 ///@}
 ///
-void init_mem() {
-    U16 sz = N4_DIC_SZ + N4_STK_SZ + N4_TIB_SZ;///< core memory block
-    dic  = (U8*)malloc(sz);                    /// * allocate Forth memory block
-    _tib = dic + N4_DIC_SZ + N4_STK_SZ;        /// * grows N4_TIB_SZ
+void init_mem(U16 sz) {
+#if defined(__AVR__)
+    if (!sz) {                                 /// * take free RAM, less C stack reserve
+        extern char *__brkval, __heap_start;
+        char *hp  = __brkval ? __brkval : &__heap_start;
+        U16  free = (U16)((char*)&sz - hp);
+        U16  rsv  = N4_MEM_RSV + N4_TIB_SZ;
+        sz = free > rsv + N4_STK_MIN ? free - rsv : N4_STK_MIN;
+    }
+#endif // __AVR__
+    if (!sz || sz > N4_MEM_MAX) sz = N4_MEM_MAX;
+    msz  = sz & ~(sizeof(DU)-1);               /// * keep stacks cell aligned
+    dic  = (U8*)malloc((size_t)msz + N4_TIB_SZ);  /// * allocate Forth memory block
+    _tib = dic + msz;                          /// * grows N4_TIB_SZ
+    _tp  = _lp = _tib;
+    rp0  = vm.rp = (DU*)dic;
+}
+///
+///> move dictionary/stack boundary, return stack content is carried along
+/// @return
+///    1: moved<br/>
+///    0: would run into data stack
+///
+U8 mem_move(U8 *p)
+{
+    DU  *r = (DU*)(dic + ((U16)(p - dic + sizeof(DU)-1) & ~(sizeof(DU)-1)));  /// * cell aligned
+    U16 n  = (U16)(vm.rp - rp0);                         /// * return stack depth
+    if ((U8*)(r + n) + N4_STK_MIN > (U8*)vm.sp) return 0;
+    if (r != rp0) {
+        memmove(r, rp0, n * sizeof(DU));
+        rp0   = r;
+        vm.rp = r + n;
+    }
+    return 1;
+}
+U8 mem_fit(U8 *top) {                          ///< one compare unless boundary must move
+    return top <= (U8*)rp0 || mem_move(top);
 }
 void set_pre(const char *code) { _pre = (char*)code; }
+U8   pending() {                               ///< preload code or tokens not consumed yet
+    for (char *p=_pre; p; p++) {
+#if ARDUINO
+        char c = pgm_read_byte(p);
+#else
+        char c = *p;
+#endif // ARDUINO
+        if (!c) break;
+        if (c > ' ') return 1;                 /// * skip trailing blank lines
+    }
+    return !_empty;
+}
 void set_io(Stream *s)  { io   = s; }          ///< initialize or redirect IO stream
 void set_hex(U8 f)      { _hex = f; }          ///< enable/disable hex numeric radix
 void set_ucase(U8 uc)   { _ucase = uc; }       ///< set case sensitiveness
+U8   get_mode()         { return _hex | (_ucase<<1) | (trc<<2); }
+void set_mode(U8 m)     { _hex = m & 1; _ucase = (m>>1) & 1; trc = m>>2; }
 char uc(char c)      {                         ///< upper case for case-insensitive matching
     return (_ucase && (c>='A')) ? c&0x5f : c;
 }
@@ -44,10 +105,10 @@ char uc(char c)      {                         ///< upper case for case-insensit
 ///
 void memstat()
 {
-    log("MEM=$");    logx(N4_DIC_SZ + N4_STK_SZ + N4_TIB_SZ); // forth memory block
-    log("[DIC=$");   logx(N4_DIC_SZ);                         // dictionary size
-    log("|STK=$");   logx(N4_STK_SZ);                         // stack size
-    log("|TIB=$");   logx(N4_TIB_SZ);
+    U16 sz = msz + N4_TIB_SZ;
+    show("MEM=$");      d_u8(sz>>8);        d_u8(sz&0xff);        // forth memory block
+    show("[DIC+STK=$"); d_u8(msz>>8);       d_u8(msz&0xff);       // shared dictionary and stacks
+    show("|TIB=$");     d_u8(N4_TIB_SZ>>8); d_u8(N4_TIB_SZ&0xff);
 #if ARDUINO
     S16 bsz = (S16)((U8*)&bsz - _tib);                        // free for TIB in bytes
     show("] auto="); d_num((U16)((U8*)&bsz - &_tib[N4_TIB_SZ]));
@@ -56,26 +117,57 @@ void memstat()
 ///@}
 ///@name Console IO Functions with Cooperative Threading support
 ///@{
+#define OUT_MASK (N4_OUT_SZ - 1)
 #if ARDUINO
 #include <avr/pgmspace.h>
+#endif // ARDUINO
+///
+///> input exhausted, the host session ends with its input (a serial port never does)
+///
+U8 eof()
+{
+#if ARDUINO
+    return 0;
+#else
+    return io->eof() ? 1 : 0;
+#endif // ARDUINO
+}
 ///
 ///> char IO from console i.e. RX/TX
+/// @return 0 at end of input
 ///
 char key()
 {
-    while (!io->available()) NanoForth::yield();
+    flush();                                   /// * show what's pending before waiting
+    while (!io->available()) {
+        if (eof()) return 0;                   /// * nothing more to come, host loop ends
+        NanoForth::yield();
+    }
     return io->read();
 }
-void d_chr(char c)     {
-    io->print(c);
-    if (c=='\n') {
-        io->flush();
-        NanoForth::yield();
+///
+///> drain output ring buffer
+///  * wait=0 writes only what the UART TX buffer takes, so interpreter never stalls
+///
+void flush(U8 wait)
+{
+    while (_otl != _ohd) {
+        U16 n = wait ? N4_OUT_SZ : io->availableForWrite();
+        if (!n) break;                         /// * UART busy, try again later
+        U16 i = _otl & OUT_MASK;
+        U16 m = ((_ohd - _otl) < (N4_OUT_SZ - i)) ? (_ohd - _otl) : (N4_OUT_SZ - i);
+        if (n < m) m = n;
+        io->write(&_obuf[i], m);               /// * batch write contiguous chunk
+        _otl += m;
     }
+    if (wait) io->flush();
+}
+#if ARDUINO
+void d_pstr(const __FlashStringHelper *s) {
+    PGM_P p = reinterpret_cast<PGM_P>(s);
+    for (char c=pgm_read_byte(p); c; c=pgm_read_byte(++p)) d_chr(c);
 }
-void d_adr(U16 a)        { d_nib(a>>8); d_nib((a>>4)&0xf); d_nib(a&0xf); }
 void d_ptr(U8 *p)        { U16 a=(U16)p; d_chr('p'); d_adr(a); }
-void d_num(S16 n)        { _hex ? io->print(n&0xffff,HEX) : io->print(n); }
 void d_pin(U16 p, U16 v) { pinMode(p, v); }
 U16  d_in(U16 p)         { return digitalRead(p); }
 void d_out(U16 p, U16 v) {
@@ -98,17 +190,45 @@ void d_out(U16 p, U16 v) {
 U16  a_in(U16 p)         { return analogRead(p); }
 void a_out(U16 p, U16 v) { analogWrite(p, v); }
 #else
-char key()               { return getchar();  }
-void d_chr(char c)       { printf("%c", c);   }
-void d_adr(U16 a)        { printf("%03x", a); }
-void d_ptr(U8 *p)        { printf("%p", p);   }
-void d_num(S16 n)        { printf(_hex ? "%x" : "%d", n); }
+void d_pstr(const char *s) { while (*s) d_chr(*s++); }
+void d_ptr(U8 *p)        {
+    char buf[20];
+    snprintf(buf, sizeof(buf), "%p", p);
+    d_pstr(buf);
+}
 void d_pin(U16 p, U16 v) { /* do nothing */ }
 U16  d_in(U16 p)         { return 0; }
 void d_out(U16 p, U16 v) { /* do nothing */ }
 U16  a_in(U16 p)         { return 0; }
 void a_out(U16 p, U16 v) { /* do nothing */ }
 #endif //ARDUINO
+void set_flush(U8 nl)    { _onl = nl; }
+void d_chr(char c)       {
+    if ((U16)(_ohd - _otl) >= N4_OUT_SZ) flush();  /// * full, must wait for UART
+    _obuf[_ohd++ & OUT_MASK] = c;
+    if (c=='\n' && _onl) {
+        flush(0);                              /// * drain what fits, no blocking
+        NanoForth::yield();
+    }
+}
+void d_adr(U16 a)        {
+#if N4_WIDE_ADR
+    d_nib(a>>12);
+#endif // N4_WIDE_ADR
+    d_nib((a>>8)&0xf); d_nib((a>>4)&0xf); d_nib(a&0xf);
+}
+void d_num(DS n)         {                     /// * render into buffer, no per-digit IO call
+    char buf[N4_CELL_SZ*3+2], *p = &buf[sizeof(buf)-1];
+    DU   u = (!_hex && n < 0) ? -n : (DU)n;
+    *p = 0;
+    do {
+        U8 d = _hex ? (u & 0xf) : (u % 10);
+        *--p = d + (d > 9 ? 'a'-10 : '0');
+        u = _hex ? (u >> 4) : (u / 10);
+    } while (u);
+    if (!_hex && n < 0) *--p = '-';
+    while (*p) d_chr(*p++);
+}
 void d_str(U8 *p)        { for (U8 i=0, sz=*p++; i<sz; i++) d_chr(*p++); }
 void d_nib(U8 n)         { d_chr((n) + ((n)>9 ? 'a'-10 : '0')); }
 void d_u8(U8 c)          { d_nib(c>>4); d_nib(c&0xf); }
@@ -143,9 +263,9 @@ void d_name(U8 op, const char *lst, U8 space)
 ///
 ///> parse a literal from string
 ///
-U8 number(U8 *str, S16 *num)
+U8 number(U8 *str, DS *num)
 {
-    S16 n   = 0;
+    DS  n   = 0;
     U8  c   = *str;
     U8  neg = (c=='-') ? (c=*++str, 1)  : 0;              /// * handle negative sign
     U8  base= c=='$' ? (str++, 16) : (_hex ? 16 : 10);    /// * handle hex number
@@ -171,51 +291,122 @@ void clear_tib() {
     get_token(1);                            ///> empty the static tib inside #get_token
 }
 ///
-///> fill input buffer from console char-by-char til CR or LF hit
+///> fetch next char from preload code, or console when exhausted
 ///
 char vkey() {
-	static char *p = _pre;                   /// capture preload Forth code
 #if ARDUINO
-    char c = p ? pgm_read_byte(p) : 0;
+    char c = _pre ? pgm_read_byte(_pre) : 0;
 #else
-    char c = *p;
+    char c = _pre ? *_pre : 0;
 #endif // ARDUINO
-	return c ? (p++, c) : key();                /// feed key() after preload exhausted
+	return c ? (_pre++, c) : key();             /// feed key() after preload exhausted
 }
-
-void _console_input()
+///
+///> check whether vkey() can return without waiting
+///
+U8 _avail() {
+#if ARDUINO
+    return (_pre && pgm_read_byte(_pre)) || io->available();
+#else
+    return (_pre && *_pre) || io->available();
+#endif // ARDUINO
+}
+///
+///> line editor state machine, consumes only chars already received
+/// @return
+///    1: a line is completed in tib (CR or LF hit)<br/>
+///    0: line not complete yet, call again later
+///
+U8 _line()
 {
-    U8 *p = _tib;
-    d_chr('\n');
-    for (;;) {
+    if (_lp==_tib && !_nl) { d_chr('\n'); _nl = 1; }   /// * new line started
+    U8 done = 0;
+#if !ARDUINO
+    if (!(_pre && *_pre)) {                  /// * host: fetch whole line in one call
+        U8  *e = _tib + N4_TIB_SZ - 2;       ///< end of room, pad and 0 follow
+        int eol, n;
+        if (_lp < e) {
+            n = io->read_line((char*)_lp, (int)(e - _lp), &eol);
+            _lp += n;
+        }
+        else {                               /// * tib full, the line must end right here
+            char c[16];
+            n = io->read_line(c, sizeof(c), &eol);
+            if (n && !_skp) { show("TIB!\n"); _skp = 1; }  /// * too long, dropped whole
+        }
+        if (eol || io->eof()) {
+            if (_skp) _lp = _tib;            /// * rest of long line drained
+            else if (_lp > _tib) {
+                *_lp     = ' ';              /// * pad extra space (in case word is 1-char)
+                *(_lp+1) = 0;                /// * terminate input string
+                done     = 1;
+            }
+            _skp = 0;
+        }
+        if (!done) return 0;                 /// * never past tib, by chars below
+    }
+#endif // !ARDUINO
+    while (!done && _avail()) {
         char c = vkey();                     /// * get one char from input stream
         if (c=='\r' || c=='\n') {            /// * split on RETURN
-            if (p > _tib) {
-                *p     = ' ';                /// * pad extra space (in case word is 1-char)
-                *(p+1) = 0;                  /// * terminate input string
-                break;                       /// * skip empty token
+            if (_lp > _tib) {
+                *_lp     = ' ';              /// * pad extra space (in case word is 1-char)
+                *(_lp+1) = 0;                /// * terminate input string
+                done     = 1;                /// * skip empty token
             }
         }
-        else if (c=='\b' && p > _tib) {      /// * backspace
-            *(--p) = ' ';
+        else if (c=='\b' && _lp > _tib) {    /// * backspace
+            *(--_lp) = ' ';
             d_chr(' ');
             d_chr('\b');
         }
-        else if (p > (U8*)(&c - sizeof(U32))) { /// * prevent buffer overrun (into auto vars)
+        else if (_lp > (U8*)(&c - sizeof(U32))) { /// * prevent buffer overrun (into auto vars)
             show("TIB!\n");
-            *p = 0;
-            break;
+            *_lp = 0;
+            done = 1;
         }
-        else *p++ = c;
+        else *_lp++ = c;
+    }
+    if (!done) return 0;                     /// * partial line so far
+    _lp = _tib;                              /// * ready for next line
+    _nl = _pmt = 0;
+    return 1;
+}
+///
+///> check whether token(s) are ready in tib, without blocking
+///
+U8 accept()
+{
+    while (_empty || *_tp==0 || *_tp=='\\') {
+        if (!_line()) return 0;              /// * wait for more input
+        _tp    = _tib;
+        _empty = 0;
+        _bol   = 1;
+        while (*_tp==' ') _tp++;             ///>  skip leading spaces
     }
-    _empty = (p==_tib);
+    return 1;
 }
 ///
-///> display OK prompt if input buffer is empty
+///> line just accepted, before any token is taken (for line compiler)
+///
+U8 *get_line() { return _bol ? _tp : NULL; }
+U8 eol()       { return _empty; }
+///
+///> move token pointer back to p (on current line), i.e. give the tokens back
+///
+void rewind(U8 *p)
+{
+    _tp    = p;
+    _empty = 0;
+    _dq    = 0;
+    _bol   = 1;
+}
+///
+///> display OK prompt (once) if input buffer is empty
 ///
 U8 ok()
 {
-	if (_empty) {
+	if (_empty && !_pmt) {
 		///
 		///> console prompt with stack dump
         /*        
@@ -225,52 +416,54 @@ U8 ok()
          *    dic-->       +-->rp  sp<--+-->tib   auto<--+
          *                         TOS NOS
          */
-		S16 *sp0 = (S16*)_tib;               /// * fetch top of heap
-		S16 *rp1 = (S16*)(vm.rp+1);
+		DS *sp0 = (DS*)_tib;                 /// * fetch top of heap
+		DS *rp1 = (DS*)(vm.rp+1);
 	    if (vm.sp <= rp1) {            /// * check stack overflow
 	        show("OVF!\n");
 	        vm.sp = rp1;               /// * stack max out
 	    }
-	    for (S16 *p=sp0-1; p >= vm.sp; p--) {   /// * dump stack content
+	    for (DS *p=sp0-1; p >= vm.sp; p--) {    /// * dump stack content
 	        d_num(*p); d_chr('_');
 	    }
 	    show("ok");                          /// * user input prompt
+	    _pmt = 1;
+	    flush();
 	}
     return _empty;
 }
 ///
 ///> capture a token from console input buffer
+///  * blocks (yielding to user tasks) if a new line is needed i.e. inside a definition
+/// @return NULL when input ended (host), callers bail
 ///
 U8 *get_token(U8 rst)
 {
-    static U8 *tp = _tib;                    ///> token pointer to input buffer
-    static U8 dq  = 0;                       ///> dot_string flag
-
-    if (rst) { tp = _tib; _empty = 1; return 0; }  /// * reset TIB for new input
-    while (_empty || *tp==0 || *tp=='\\') {
-        _console_input();                    ///>  read from console (with trailing blank)
-        while (*tp==' ') tp++;               ///>  skip leading spaces
+    if (rst) { _tp = _tib; _empty = 1; return 0; }  /// * reset TIB for new input
+    while (!accept()) {                      /// * wait for next line
+        if (eof()) return NULL;              /// * input ended, host loop ends
+        NanoForth::yield();
     }
-    if (!dq) {
-        while (*tp=='(' && *(tp+1)==' ') {   /// * handle ( ...) comment, TODO: multi-line
-            while (*tp && *tp++!=')');       ///> find the end of comment
-            while (*tp==' ') tp++;           ///> skip trailing spaces
+    _bol = 0;
+    if (!_dq) {
+        while (*_tp=='(' && *(_tp+1)==' ') { /// * handle ( ...) comment, TODO: multi-line
+            while (*_tp && *_tp++!=')');     ///> find the end of comment
+            while (*_tp==' ') _tp++;         ///> skip trailing spaces
         }
     }
-    U8 *p = (U8*)tp;
-    U8 cx = dq ? '"' : ' ';                  /// * set delimiter
+    U8 *p = (U8*)_tp;
+    U8 cx = _dq ? '"' : ' ';                 /// * set delimiter
     U8 sz = 0;
-    while (*tp && *tp!='(' && *tp++!=cx) sz++;/// * count token length
+    while (*_tp && *_tp!='(' && *_tp++!=cx) sz++;/// * count token length
     if (trc) {                               /// * optionally print token for debugging
         d_chr('\n');
         for (int i=0; i<5; i++) {
             d_chr(i<sz ? (*(p+i)<0x20 ? '_' : *(p+i)) : ' ');
         }
     }
-    while (*tp==' ') tp++;                   /// * skip spaces, advance pointer to next token
-    if (*tp==0 || *tp=='\\') { tp = _tib; _empty = 1; }
+    while (*_tp==' ') _tp++;                 /// * skip spaces, advance pointer to next token
+    if (*_tp==0 || *_tp=='\\') { _tp = _tib; _empty = 1; }
 
-    dq  = (*p=='.' && *(p+1)=='"');          /// * flag token was dot_string
+    _dq = (*p=='.' && *(p+1)=='"');          /// * flag token was dot_string
 
     return p;                                /// * return pointer to token
 }
@@ -8,16 +8,34 @@
 #include "n4.h"
 ///
 ///@name Default Heap sizing
+///
+/// dictionary, return and data stacks share one region sized at setup time,
+/// the dictionary/return stack boundary (rp0) moves with the dictionary
 ///@{
-constexpr U16 N4_DIC_SZ = 0x400;  /**< default dictionary size             */
-constexpr U16 N4_STK_SZ = 0x80;   /**< default parameter/return stack size */
-constexpr U16 N4_TIB_SZ = 0x80;   /**< terminal input buffer size          */
+#if N4_WIDE_ADR
+constexpr U16 N4_MEM_MAX = 0xf000; /**< region cap (16-bit branch address)   */
+#else
+constexpr U16 N4_MEM_MAX = 0x1000; /**< region cap (12-bit branch address)   */
+#endif // N4_WIDE_ADR
+constexpr U16 N4_STK_MIN = 0x40;   /**< stack room kept when dictionary grows */
+constexpr U16 N4_TIB_SZ  = 0x80;   /**< terminal input buffer size           */
+#if ARDUINO
+constexpr U16 N4_MEM_RSV = 0x100;  /**< RAM left to C stack and libraries    */
+#endif // ARDUINO
 ///@}
+///
+///@name Console Output Buffer
+///@{
 #if ARDUINO
-#define show(s)      { io->print(F(s)); io->flush(); }
+constexpr U16 N4_OUT_SZ = 0x20;   /**< output ring buffer size (power of 2) */
+constexpr U8  N4_OUT_NL = 1;      /**< default flush policy, drain on newline */
+#define show(s)      d_pstr(F(s))
 #else
-#define show(s)      log(s)
+constexpr U16 N4_OUT_SZ = 0x400;  /**< output ring buffer size (power of 2) */
+constexpr U8  N4_OUT_NL = 0;      /**< default flush policy, drain when full or at prompt */
+#define show(s)      d_pstr(s)
 #endif // ARDUINO
+///@}
 ///
 ///@name Memory Access Ops
 ///
@@ -27,45 +45,116 @@ constexpr U16 N4_TIB_SZ = 0x80;   /**< terminal input buffer size          */
 /// @brief 2-byte write, prevent alignment issue (on 32-bit CPU) and preserve Big-Endian encoding
 /// @def GET16
 /// @brief 2-byte read, prevent alignment issue (on 32-bit CPU) and preserve Big-Endian encoding
+/// @def ENCC
+/// @brief cell-wide write (literals, @, !, VAR storage), same as ENC16 with 16-bit cells
+/// @def GETC
+/// @brief cell-wide read, same as GET16 with 16-bit cells
 ///@{
 #define ENC8(p, c)     (*(U8*)(p)++=(U8)(c))
 #define ENC16(p, n)    { U16 x=(U16)(n); ENC8(p,(x)>>8); ENC8(p,(x)&0xff); }
 #define GET16(p)       (((U16)(*(U8*)(p))<<8) + *((U8*)(p)+1))
+#if N4_CELL_SZ==2
+#define ENCC(p, n)     ENC16(p, n)
+#define GETC(p)        GET16(p)
+#else
+template<typename T>
+INLINE void enc_be(U8 *&p, T v) {              ///< big-endian write, any width
+    for (int i=sizeof(T)-1; i>=0; i--) ENC8(p, v >> (i<<3));
+}
+template<typename T>
+INLINE T get_be(U8 *p) {                       ///< big-endian read, any width
+    T v = 0;
+    for (U8 i=0; i<sizeof(T); i++) v = (v << 8) | p[i];
+    return v;
+}
+#define ENCC(p, n)     enc_be<DU>(p, (DU)(n))
+#define GETC(p)        get_be<DU>((U8*)(p))
+#endif // N4_CELL_SZ
+///@}
+///
+///@name Code Operand Access (see N4_NATIVE_END)
+///
+/// @def ENCL
+/// @brief literal operand write (I_LIT), native order when enabled
+/// @def GETL
+/// @brief literal operand read
+/// @def ENCA
+/// @brief 16-bit branch address write (wide mode)
+/// @def GETA
+/// @brief 16-bit branch address read (wide mode)
+///@{
+#if N4_NATIVE_END
+template<typename T>
+INLINE void enc_ne(U8 *&p, T v) {              ///< native write, unaligned safe
+    memcpy(p, &v, sizeof(T));
+    p += sizeof(T);
+}
+template<typename T>
+INLINE T get_ne(U8 *p) {                       ///< native read, one load where allowed
+    T v;
+    memcpy(&v, p, sizeof(T));
+    return v;
+}
+#define ENCL(p, n)     enc_ne<DU>(p, (DU)(n))
+#define GETL(p)        get_ne<DU>((U8*)(p))
+#define ENCA(p, n)     enc_ne<U16>(p, (U16)(n))
+#define GETA(p)        get_ne<U16>((U8*)(p))
+#else
+#define ENCL(p, n)     ENCC(p, n)
+#define GETL(p)        GETC(p)
+#define ENCA(p, n)     ENC16(p, n)
+#define GETA(p)        GET16(p)
+#endif // N4_NATIVE_END
 ///@}
 ///
 /// nanoForth memory and IO helper functions
 ///
 typedef struct {
-    U16    *rp     { 0 };           ///< base of return stack
-    S16    *sp     { 0 };           ///< top of data stack
+    DU     *rp     { 0 };           ///< top of return stack
+    DS     *sp     { 0 };           ///< top of data stack
 } N4Task;
 
 namespace N4Core
 {
     extern N4Task vm;               ///< VM state
     extern U8     *dic;             ///< base of dictionary
+    extern U16    msz;              ///< size of dictionary+stacks region
+    extern DU     *rp0;             ///< base of return stack (dictionary/stack boundary)
     extern U8      trc;             ///< tracing flag
     extern Stream *io;              ///< default to Arduino Serial Monitor
 
-    void init_mem();                ///< initialize MMU
+    void init_mem(U16 sz);          ///< initialize MMU, sz=0: take what is available
+    U8   mem_move(U8 *p);           ///< move boundary to p (return stack carried), 0: region full
+    U8   mem_fit(U8 *top);          ///< make dictionary room up to top, 0: region full
     void memstat();                 ///< display MMU statistics
 
     void set_pre(const char *code); ///< set embedded Forth code
+    U8   pending();                 ///< check whether preload code or input tokens remain
     void set_io(Stream *s);         ///< initialize or redirect IO stream
     void set_hex(U8 f);             ///< enable/disable hex numeric radix
     void set_ucase(U8 uc);          ///< set case sensitiveness
+    U8   get_mode();                ///< fetch radix, case and tracing flags (for VM snapshot)
+    void set_mode(U8 m);            ///< restore radix, case and tracing flags
     char uc(char c);
     ///
     ///@name dot_* for Console Input/Output Routines
     ///@{
+    U8   eof();                     ///< input exhausted (host only, 0 on Arduino)
     char key();                     ///< Arduino's Serial.getchar(), yield to user tasks when waiting
-    void d_chr(char c);             ///< print a char to console
-    void d_adr(U16 a);              ///< print a 12-bit address
+    void set_flush(U8 nl);          ///< flush policy, 1: drain on every newline, 0: when full or at prompt
+    void flush(U8 wait=1);          ///< drain output buffer, 0: only what UART can take without blocking
+    void d_chr(char c);             ///< print a char to console (buffered)
+#if ARDUINO
+    void d_pstr(const __FlashStringHelper *s); ///< print a string in program memory
+#else
+    void d_pstr(const char *s);     ///< print a string
+#endif // ARDUINO
+    void d_adr(U16 a);              ///< print a 12-bit (or 16-bit in wide mode) address
     void d_str(U8 *p);              ///< handle dot string (byte-stream leading with length)
     void d_ptr(U8 *p);              ///< print a pointer
     void d_nib(U8 n);               ///< print a nibble
     void d_u8(U8 c);                ///< print a 8-bit hex number
-    void d_num(S16 n);              ///< sent a number literal to console
+    void d_num(DS n);               ///< sent a number literal to console
     void d_pin(U16 p, U16 v);       ///< set pin a given pinMode (INPUT, OUTPUT)
     U16  d_in(U16 p);               ///< fetch from GPIO port
     void d_out(U16 p, U16 v);       ///< send output to GPIO ports
@@ -87,11 +176,15 @@ namespace N4Core
     ///@name Input buffer Functions
     ///@{
     void clear_tib();               ///< reset input buffer
-    U8   ok();                      ///< check whether input buffer is empty
-    U8   *get_token(U8 rst=0);      ///< get a token from console input
+    U8   accept();                  ///< collect input without blocking, 1: token(s) ready
+    U8   ok();                      ///< show prompt once, return whether input buffer is empty
+    U8   *get_token(U8 rst=0);      ///< get a token from console input, NULL when input ended
+    U8   *get_line();               ///< line just accepted (no token taken yet), or NULL
+    U8   eol();                     ///< all tokens of current line are taken
+    void rewind(U8 *p);             ///< give tokens back, re-read them from p
     U8   number(                    ///< process a literal from string given
         U8 *tkn,                    ///< token string of a number
-        S16 *num                    ///< number pointer for return value
+        DS *num                     ///< number pointer for return value
         );
     ///
     /// scan token from a given string list
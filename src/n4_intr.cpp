@@ -4,35 +4,39 @@
  *    Note: with volatile struct reduce 100 cycles from 14ms to 11ms
  */
 #include "n4_intr.h"
-///
-/// nanoForth Interrupt handler -  static variables
-///
-typedef struct {
-    U8  t_idx { 0 };           ///< max timer interrupt slot index
-    U16 t_max[8];              ///< timer CTC top value
-    U16 xt[11];                ///< vectors 0-7: timer, 8-10 pin change
-    volatile U16 t_cnt[8];     ///< timer CTC counters
-    volatile U8  t_hit { 0 };  ///< 8-bit for 8 timer ISR,
-    volatile U8  p_hit { 0 };  ///< 3-bit for pin change ISR
-} IsrRec;                      ///< Interrupt Record Keeper
 
 namespace N4Intr {
 IsrRec ir;                     ///< real-time interrupt record
 
 void reset() {
     CLI();
-    ir.t_idx = ir.t_hit = ir.p_hit = 0;
+    ir.t_idx = ir.t_hit = ir.p_hit = ir.en = 0;
+    for (U8 i=0; i < 3; i++)  ir.p_msk[i] = 0;
     for (U8 i=0; i < 11; i++) ir.xt[i] = 0;
     SEI();
 }
+///
+///> re-arm interrupt hardware after the record is restored from a snapshot
+///
+void restore() {
+    ir.t_hit = ir.p_hit = 0;
+#if ARDUINO
+    CLI();
+    PCMSK0 = ir.p_msk[0];
+    PCMSK1 = ir.p_msk[1];
+    PCMSK2 = ir.p_msk[2];
+    SEI();
+#endif // ARDUINO
+    enable_timer(ir.en & 1);
+    enable_pci(ir.en & 2);
+}
 #if ARDUINO
 #define _fake_intr(hx)
 #else // !ARDUINO
-U8  tmr_on = 0;               ///< fake timer enabler
 void _fake_intr(U16 hx)
 {
     static U8 n = 0;               // fake interrupt
-    if (tmr_on && !hx && ++n >= 50) {
+    if ((ir.en & 1) && !hx && ++n >= 50) {
         n=0; ir.t_hit = 3;
     }
 }
@@ -77,8 +81,8 @@ void add_tmisr(U16 i, U16 n, U16 xt) {
 }
 #if !ARDUINO
 void add_pcisr(U16 p, U16 xt) {}   // mocked functions for x86
-void enable_pci(U16 f)        {}
-void enable_timer(U16 f)      { tmr_on = f; }
+void enable_pci(U16 f)        { ir.en = f ? (ir.en | 2) : (ir.en & ~2); }
+void enable_timer(U16 f)      { ir.en = f ? (ir.en | 1) : (ir.en & ~1); }
 #else  // ARDUINO
 ///
 ///@name N4Intr static variables
@@ -88,20 +92,21 @@ void add_pcisr(U16 p, U16 xt) {
     CLI();
     if (p < 8)       {
         ir.xt[10] = xt;
-        PCMSK2 |= 1 << p;
+        PCMSK2 = ir.p_msk[2] |= 1 << p;
     }
     else if (p < 13) {
         ir.xt[8] = xt;
-        PCMSK0 |= 1 << (p - 8);
+        PCMSK0 = ir.p_msk[0] |= 1 << (p - 8);
     }
     else {
         ir.xt[9] = xt;
-        PCMSK1 |= 1 << (p - 14);
+        PCMSK1 = ir.p_msk[1] |= 1 << (p - 14);
     }
     SEI();
 }
 void enable_pci(U16 f) {
     CLI();
+    ir.en = f ? (ir.en | 2) : (ir.en & ~2);
     if (f) {
         if (ir.xt[8])  PCICR |= _BV(PCIE0);     // enable PORTB
         if (ir.xt[9])  PCICR |= _BV(PCIE1);     // enable PORTC
@@ -112,6 +117,7 @@ void enable_pci(U16 f) {
 }
 void enable_timer(U16 f) {
     CLI();
+    ir.en = f ? (ir.en | 1) : (ir.en & ~1);
     TCCR2A = TCCR2B = TCNT2 = 0;                // reset counter
     if (f) {
         TCCR2A = _BV(WGM21);                    // Set CTC mode
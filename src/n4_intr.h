@@ -16,8 +16,25 @@
 #define SEI()
 #endif // ARDUINO
 
+///
+/// nanoForth Interrupt handler -  static variables
+///
+typedef struct {
+    U8  t_idx { 0 };           ///< max timer interrupt slot index
+    U8  en    { 0 };           ///< enable flags, bit0: timer, bit1: pin change
+    U8  p_msk[3];              ///< pin change masks (PCMSK0~2)
+    U16 t_max[8];              ///< timer CTC top value
+    U16 xt[11];                ///< vectors 0-7: timer, 8-10 pin change
+    volatile U16 t_cnt[8];     ///< timer CTC counters
+    volatile U8  t_hit { 0 };  ///< 8-bit for 8 timer ISR,
+    volatile U8  p_hit { 0 };  ///< 3-bit for pin change ISR
+} IsrRec;                      ///< Interrupt Record Keeper
+
 namespace N4Intr {
+    extern IsrRec ir;              ///< real-time interrupt record (kept in VM snapshot)
+
     void reset();                  ///< reset interrupts
+    void restore();                ///< re-arm hardware from interrupt record (after resume)
     U16  isr();                    ///< fetch interrupt service routines
 
     void add_tmisr(
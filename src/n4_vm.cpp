@@ -5,11 +5,11 @@
  * #### Forth VM stack opcode macros (notes: rp grows upward and may collide with sp)
  *
  * @code memory space
- *                                    SP0 (sp max to protect overwritten of vm object)
- *        mem[...dic_sz...|...stk_sz...|......heap......]max
- *           |            |            |                |
- *           dic-->       +-->rp  sp<--+-->tib   auto<--+
- *                                TOS NOS
+ *                       rp0 (moves with here)  SP0 (sp max to protect overwritten of vm object)
+ *        mem[...dic...here|...msz - here.....|......heap......]max
+ *           |             |                  |                |
+ *           dic-->        +-->rp        sp<--+-->tib   auto<--+
+ *                                      TOS NOS
  * @endcode
  */
 #include "n4_core.h"
@@ -21,12 +21,16 @@ using namespace N4Core;                             /// * VM built with core uni
 ///
 ///@name Data Stack and Return Stack Ops
 ///@{
-#define SP0            ((S16*)&dic[N4_DIC_SZ + N4_STK_SZ])
+#define SP0            ((DS*)&dic[msz])
 #define TOS            (*vm.sp)                     /**< pointer to top of current stack     */
 #define SS(i)          (*(vm.sp+(i)))               /**< pointer to the nth on stack         */
-#define PUSH(v)        (*(--vm.sp)=(S16)(v))        /**< push v onto parameter stack         */
+#define PUSH(v)        (*(--vm.sp)=(DS)(v))         /**< push v onto parameter stack         */
 #define POP()          (*vm.sp++)                   /**< pop value off parameter stack       */
-#define RPUSH(a)       (*(vm.rp++)=(U16)(a))        /**< push address onto return stack      */
+#if N4_STK_CHECK
+#define RPUSH(a)       _rpush((DU)(a))              /**< push onto return stack, checked     */
+#else
+#define RPUSH(a)       (*(vm.rp++)=(DU)(a))         /**< push address onto return stack      */
+#endif // N4_STK_CHECK
 #define RPOP()         (*(--vm.rp))                 /**< pop address from return stack       */
 ///@}
 ///@name Dictionary Index <=> Pointer Converters
@@ -35,6 +39,125 @@ using namespace N4Core;                             /// * VM built with core uni
 #define IDX(p)         ((U16)((U8*)(p) - dic))      /**< convert memory pointer to a dictionary index */
 ///@}
 namespace N4VM {
+#if N4_STK_CHECK
+U8 _rovf { 0 };                          ///< return stack ran into data stack, _nest unwinds
+///
+///> the one return stack push, stops short of the data stack (>R FOR DO locals calls ISR)
+///
+INLINE void _rpush(DU v)
+{
+    if ((U8*)(vm.rp + 1) > (U8*)vm.sp) { _rovf = 1; return; }
+    *(vm.rp++) = v;
+}
+#endif // N4_STK_CHECK
+///
+///@name Interpret Mode Line Cache
+/// @brief
+///    a line is compiled into the free space above here as [text...0][code...RET]<br/>
+///    and run with _nest, a repeated line (matched by hash then text) skips compiling<br/>
+///    cache holds only while here stays put, any immediate word flushes it
+///@{
+#if ARDUINO
+constexpr U8 N4_LNC_SZ = 2;              ///< number of cached lines
+#else
+constexpr U8 N4_LNC_SZ = 8;
+#endif // ARDUINO
+typedef struct {
+    U16 h;                               ///< hash of line text
+    U16 src;                             ///< dictionary index of line text
+    U16 xt;                              ///< dictionary index of compiled line
+#if N4_EFF
+    EffRec e;                            ///< stack effect, taken when compiled
+#endif // N4_EFF
+} LnRec;
+LnRec _lnc[N4_LNC_SZ];                   ///< cached lines
+U8    _lnn { 0 };                        ///< number of lines cached
+U8    _lnv { 0 };                        ///< round-robin victim
+U16   _lnh { LFA_END };                  ///< here when cache was filled
+U16   _lnt { 0 };                        ///< top of scratch area
+#if N4_EFF
+typedef struct {
+    U16    xt;                           ///< word called from console
+    EffRec e;                            ///< its stack effect, taken on first call
+} WfRec;
+WfRec _wfc[N4_LNC_SZ];                   ///< effects of words called, dropped with lines
+U8    _wfn { 0 };                        ///< number of word effects kept
+#define WFC_CLEAR() (_wfn = 0)
+#else
+#define WFC_CLEAR()
+#endif // N4_EFF
+///@}
+void _lnc_clear() { _lnn = _lnv = 0; _lnh = LFA_END; WFC_CLEAR(); }
+#if N4_AOT
+///
+///@name Native Code (words translated ahead of time, see n4 -c)
+///@{
+const AotRec *_aot  { NULL };            ///< translated words, ascending xt
+U16           _aotm { 0 };               ///< number of words registered
+U16           _aotn { 0 };               ///< number of words in use, 0 once their code changed
+U16           _aots { 0 };               ///< code sum of the words when translated
+///@}
+///
+///> run native code only while dictionary holds the code it was translated from
+///
+void _aot_check()
+{
+    U16 s = 0, top = IDX(N4Asm::here);
+    _aotn = 0;
+    for (U16 i=0; i<_aotm; i++) {
+        if (_aot[i].xt >= top) return;   /// * forgotten
+        s = N4Asm::code_sum(_aot[i].xt, s);
+    }
+    if (s==_aots) _aotn = _aotm;
+}
+///
+///> native code of word at xt, or NULL
+///
+INLINE FPTR _native(U16 xt)
+{
+    U16 lo = 0, hi = _aotn;
+    while (lo < hi) {                    ///> binary search
+        U16 m = (lo + hi) >> 1;
+        U16 x = _aot[m].xt;
+        if (x==xt) return _aot[m].fn;
+        if (x < xt) lo = m + 1;
+        else        hi = m;
+    }
+    return NULL;
+}
+///
+///> run native code on a cell of return stack, as a call would take (C recursion stays bounded)
+/// @return 1: ran, 0: return stack full
+///
+U8 _run(FPTR fn)
+{
+    U16 d = (U16)(vm.rp - rp0);
+    RPUSH(LFA_END);
+#if N4_STK_CHECK
+    if (_rovf) return 0;                 /// * caller unwinds, see _nest
+#endif // N4_STK_CHECK
+    fn();
+    vm.rp = rp0 + d;                     /// * , or ALO may have moved rp0
+    return 1;
+}
+#endif // N4_AOT
+///
+///> park dictionary/stack boundary on top of dictionary and cached lines (return stack empty)
+///
+void _park()
+{
+    U16 here_i = IDX(N4Asm::here);
+    if (_lnh != here_i) {                ///> dictionary changed, drop cached lines
+        _lnn = _lnv = 0;
+        WFC_CLEAR();
+        _lnh = _lnt = here_i;
+    }
+    vm.rp = rp0;
+    mem_move(DIC(_lnt));
+#if N4_STK_CHECK
+    if (_rovf) { show("OVF!\n"); _rovf = 0; }  /// * pushed at interpreter level
+#endif // N4_STK_CHECK
+}
 ///
 ///> reset virtual machine
 ///
@@ -42,14 +165,26 @@ void _nest(U16 xt);                      /// * forward declaration
 void _init() {
     show(APP_NAME); show(APP_VERSION);   /// * show init prompt
 
-    vm.rp = (U16*)DIC(N4_DIC_SZ);        /// * reset return stack pointer
+    vm.rp = rp0;                         /// * reset return stack pointer
     vm.sp = SP0;                         /// * reset data stack pointer
     N4Intr::reset();                     /// * init interrupt handler
+    _lnc_clear();                        /// * dictionary is about to change
 
     U16 xt = N4Asm::reset();             /// * reload EEPROM and reset assembler
+    if (resume()) {                      /// * warm restart from VM snapshot (see HBR)
+#if N4_AOT
+        _aot_check();
+#endif // N4_AOT
+        show("resume\n");
+        return;
+    }
+    _park();                             /// * return stack right above dictionary
+#if N4_AOT
+    _aot_check();                        /// * image loaded, native code may apply
+#endif // N4_AOT
     if (xt != LFA_END) {                 /// * check autorun addr has been setup? (see SEX)
         show("reset\n");
-        _nest(xt + 2 + 3);               /// * execute last saved colon word in EEPROM
+        call(xt + 2 + 3);                /// * execute last saved colon word in EEPROM
     }
 }
 ///
@@ -83,11 +218,16 @@ void _immediate(U16 op)
         ///> interrupt handlers
         case 3: N4Intr::add_pcisr(               /// * PCI, create a pin change interrupt handler
                 POP(), N4Asm::query()); break;
-        case 4:                                  /// * TMI, create a timer interrupt handler
+        case 4: {                                /// * TMI, create a timer interrupt handler
             op = POP();                          ///< tmp = ISR slot#
-            N4Intr::add_tmisr(
-                op, POP(),
-                N4Asm::query());        break;   /// * period in multiply of 10ms
+            U16 n  = POP();                      ///< period in multiply of 10ms
+            U16 xt = N4Asm::query();
+#if N4_WCT
+            U32 lo, hi;                          /// * warn when it may outrun its period
+            if (xt && N4Asm::wcet(xt, &lo, &hi) && hi > (U32)n * 10 * WC_MS) show("WCT!\n");
+#endif // N4_WCT
+            N4Intr::add_tmisr(op, n, xt);
+        } break;
         ///> numeric radix
         case 5: set_hex(1);             break;   /// * HEX
         case 6: set_hex(0);             break;   /// * DEC
@@ -105,38 +245,306 @@ void _immediate(U16 op)
 #if ARDUINO
         case 14: _init();               break;   /// * BYE, restart
 #else
-        case 14: exit(0);               break;   /// * BYE, bail to OS
+        case 14: flush(); exit(0);      break;   /// * BYE, bail to OS
 #endif // ARDUINO
+        case 15:                                 /// * UPL, binary image upload
+            N4Intr::reset();                     /// * ISR xt will be stale
+            N4Asm::upload();            break;
+        case 16: if (!hibernate()) show("HBR!\n"); break;  /// * HBR, snapshot VM into EEPROM
+        case 17: if (!resume())    show("RSM!\n"); break;  /// * RSM, restore VM from snapshot
+        ///> deferred words
+        case 18: N4Asm::defer();        break;   /// * DEF, create a deferred word
+        case 19:                                 /// * IS, point deferred word to xt
+            op = N4Asm::query();
+            if (op) N4Asm::is(op, POP());
+            break;
+#if N4_WCT
+        case 20: N4Asm::wcet();         break;   /// * WCT, best and worst case cycles of a word
+#endif // N4_WCT
+#if N4_OPT
+        case 21: N4Asm::optimize();     break;   /// * OPT, rewrite hot words from call counts
+#endif // N4_OPT
+        default: show("?\n");                   /// * word left out of this build
         }
 }
 ///
-///> 32-bit operators
+///> double-cell operators (32-bit with 16-bit cells, 64-bit with 32-bit cells)
 /// @brief: stand-alone functions to reduce register allocation in _invoke
 ///
-#define HI16(u)    ((U16)((u)>>16))
-#define LO16(u)    ((U16)((u)&0xffff))
-#define TO32(u, v) (((S32)(u)<<16) | LO16(v))
+#define HICELL(u)  ((DU)((u)>>(N4_CELL_SZ*8)))
+#define LOCELL(u)  ((DU)(u))
+#define TODBL(u, v) (((DD)(u)<<(N4_CELL_SZ*8)) | LOCELL(v))
 void _clock() {
-    U32 u = millis();       // millisecond (32-bit value)
-    PUSH(LO16(u));
-    PUSH(HI16(u));
+    DD u = millis();        // millisecond (32-bit value), as a double
+    PUSH(LOCELL(u));
+    PUSH(HICELL(u));
 }
 void _dplus() {
-    S32 v = TO32(SS(2), SS(3)) + TO32(TOS, SS(1));
+    DD v = TODBL(SS(2), SS(3)) + TODBL(TOS, SS(1));
     POP(); POP();
-    SS(1) = (S16)LO16(v);
-    TOS   = (S16)HI16(v);
+    SS(1) = (DS)LOCELL(v);
+    TOS   = (DS)HICELL(v);
 }
 void _dminus() {
-    S32 v = TO32(SS(2), SS(3)) - TO32(TOS, SS(1));
+    DD v = TODBL(SS(2), SS(3)) - TODBL(TOS, SS(1));
     POP(); POP();
-    SS(1) = (S16)LO16(v);
-    TOS   = (S16)HI16(v);
+    SS(1) = (DS)LOCELL(v);
+    TOS   = (DS)HICELL(v);
 }
 void _dneg() {
-    S32 v = -TO32(TOS, SS(1));
-    SS(1) = (S16)LO16(v);
-    TOS   = (S16)HI16(v);
+    DD v = -TODBL(TOS, SS(1));
+    SS(1) = (DS)LOCELL(v);
+    TOS   = (DS)HICELL(v);
+}
+///
+///> fixed-point formats, Q8.8 and Q1.15 with 16-bit cells (Q16.16 and Q1.31 with 32-bit cells)
+///
+constexpr U8 Q_LO   = N4_CELL_SZ*4;          ///< fraction bits of Q8.8, i.e. Q*, Q/, TBL
+constexpr U8 Q_HI   = N4_CELL_SZ*8 - 1;      ///< fraction bits of Q1.15, i.e. F*, LRP
+constexpr DS DS_MAX = (DS)((DU)-1 >> 1);     ///< largest cell value
+constexpr DS DS_MIN = -DS_MAX - 1;           ///< smallest cell value
+
+DS _sat(DD v) {                             ///< saturate a double into a cell
+    return v > DS_MAX ? DS_MAX : (v < DS_MIN ? DS_MIN : (DS)v);
+}
+DS _qmul(DS a, DS b, U8 q) {                ///< rounded, saturated fixed-point product
+    return _sat(((DD)a * b + ((DD)1 << (q-1))) >> q);
+}
+DS _table(DS x, U8 *p) {                    ///< Q8.8 index into table [n, y0, y1, ..., yn-1]
+    DS n = (DS)GETC(p);
+    if (n < 1) return 0;
+    DD xmax = (DD)(n-1) << Q_LO;
+    DD xi   = x < 0 ? 0 : (x > xmax ? xmax : x);       /// * clamp to table ends
+    DS i    = (DS)(xi >> Q_LO);
+    DS y0   = (DS)GETC(p + N4_CELL_SZ*(i+1));
+    if (i == n-1) return y0;
+    DS y1   = (DS)GETC(p + N4_CELL_SZ*(i+2));
+    DD f    = xi & (((DD)1 << Q_LO) - 1);
+    return (DS)(y0 + (((DD)y1 - y0) * f >> Q_LO));       /// * linear between entries
+}
+///
+///> block and array operators on dictionary addresses
+/// @brief
+///    blocks must lie below here (i.e. CRE/ALO space), "ADR!" otherwise<br/>
+///    bytes go through libc (vectorized on hosts), cells through @ ! byte order
+///
+U8 *_blk(DU a, UD sz) {                     ///< bounds checked address of a block (sz never wraps)
+    if ((UD)a + sz > (UD)IDX(N4Asm::here)) {
+        show("ADR!\n");
+        return NULL;
+    }
+    return DIC(a);
+}
+void _array(U8 op) {                        ///< SUM, AMN, AMX ( a n -- x ), DOT ( a1 a2 n -- d )
+    DU n  = POP();
+    U8 *q = op==3 ? _blk(POP(), (UD)n*N4_CELL_SZ) : NULL;
+    U8 *p = _blk(TOS, (UD)n*N4_CELL_SZ);
+    if (!p || (op==3 && !q)) { TOS = 0; if (op==0 || op==3) PUSH(0); return; }
+    DD v  = op==1 ? DS_MAX : (op==2 ? DS_MIN : 0);
+    for (DU i=0; i<n; i++, p+=N4_CELL_SZ) {
+        DS x = (DS)GETC(p);
+        switch (op) {
+        case 0: v += x;                                 break;  // SUM
+        case 1: if (x < v) v = x;                       break;  // AMN
+        case 2: if (x > v) v = x;                       break;  // AMX
+        case 3: v += (DD)x * (DS)GETC(q); q += N4_CELL_SZ; break; // DOT
+        }
+    }
+    if (op==1 || op==2) { TOS = n ? (DS)v : 0; return; }
+    TOS = (DS)LOCELL(v);                    /// * SUM, DOT return a double
+    PUSH(HICELL(v));
+}
+void _ring(DS v, DU a) {                    ///< CB! ( v a -- ), buffer [n, idx, e0..en-1]
+    U8 *p = _blk(a, 2*N4_CELL_SZ);
+    if (!p) return;
+    DS n = (DS)GETC(p);
+    DS i = (DS)GETC(p + N4_CELL_SZ);
+    if (n < 1 || i < 0 || i >= n || !_blk(a, ((UD)n+2)*N4_CELL_SZ)) return;
+    U8 *e = p + N4_CELL_SZ*(i+2);
+    ENCC(e, v);                             /// * store element
+    e = p + N4_CELL_SZ;
+    ENCC(e, (i+1) < n ? i+1 : 0);           /// * advance index, wrap around
+}
+///
+///> mixed-precision, fixed-point and block operators, reached through EXT prefix
+///
+void _extend(U8 op)
+{
+    switch (op) {
+    case 0: {                       // UM* ( u1 u2 -- ud )
+        UD v = (UD)(DU)SS(1) * (DU)TOS;
+        SS(1) = (DS)LOCELL(v);
+        TOS   = (DS)HICELL(v);
+    } break;
+    case 1: {                       // M* ( n1 n2 -- d )
+        DD v = (DD)SS(1) * TOS;
+        SS(1) = (DS)LOCELL(v);
+        TOS   = (DS)HICELL(v);
+    } break;
+    case 2: {                       // UM/ ( ud u -- urem uquot ), i.e. UM/MOD, saturated on 0 divisor
+        DU u = POP();
+        UD v = ((UD)(DU)TOS << (N4_CELL_SZ*8)) | (DU)SS(1);
+        SS(1) = u ? (DS)(v % u) : 0;
+        TOS   = u ? (DS)(v / u) : (DS)(DU)-1;
+    } break;
+    case 3: {                       // */ ( n1 n2 n3 -- n1*n2/n3 ), saturated on 0 divisor
+        DS n = POP();
+        DD v = (DD)SS(1) * TOS;
+        vm.sp++;
+        TOS = n ? (DS)(v / n) : (v < 0 ? DS_MIN : DS_MAX);
+    } break;
+    case 4: {                       // */M ( n1 n2 n3 -- rem quot ), i.e. */MOD, saturated on 0 divisor
+        DS n = POP();
+        DD v = (DD)SS(1) * TOS;
+        SS(1) = n ? (DS)(v % n) : 0;
+        TOS   = n ? (DS)(v / n) : (v < 0 ? DS_MIN : DS_MAX);
+    } break;
+    case 5: {                       // Q* ( q1 q2 -- q1*q2 ), Q8.8, rounded and saturated
+        DS n = POP();
+        TOS = _qmul(TOS, n, Q_LO);
+    } break;
+    case 6: {                       // Q/ ( q1 q2 -- q1/q2 ), Q8.8, saturated (also on 0 divisor)
+        DS n = POP();
+        TOS = n ? _sat((DD)TOS * ((DD)1 << Q_LO) / n) : (TOS < 0 ? DS_MIN : DS_MAX);
+    } break;
+    case 7: {                       // F* ( f1 f2 -- f1*f2 ), Q1.15, rounded and saturated
+        DS n = POP();
+        TOS = _qmul(TOS, n, Q_HI);
+    } break;
+    case 8: {                       // S+ ( n1 n2 -- n1+n2 ), saturated
+        DS n = POP();
+        TOS = _sat((DD)TOS + n);
+    } break;
+    case 9: {                       // LRP ( a b t -- a+(b-a)*t ), t in Q1.15, clamped to [0,1)
+        DS t = POP(); if (t < 0) t = 0;
+        DS b = POP();
+        DD v = (DD)TOS * (((DD)1 << Q_HI) - t) + (DD)b * t;  /// * weights add up to 1.0, no overflow
+        TOS = (DS)((v + ((DD)1 << (Q_HI-1))) >> Q_HI);
+    } break;
+    case 10: {                      // TBL ( x adr -- y ), x in Q8.8, interpolated table lookup
+        U8 *p = DIC(POP());
+        TOS = _table(TOS, p);
+    } break;
+    case 11: {                      // MOV ( a1 a2 u -- ), copy u bytes (overlap safe)
+        DU u = POP(), d = POP(), s = POP();
+        U8 *pd, *ps;
+        if ((pd = _blk(d, u)) && (ps = _blk(s, u))) memmove(pd, ps, u);
+    } break;
+    case 12: {                      // FIL ( a u c -- ), fill u bytes with c
+        U8 c = (U8)POP();
+        DU u = POP();
+        U8 *p = _blk(POP(), u);
+        if (p) memset(p, c, u);
+    } break;
+    case 13: {                      // CMP ( a1 a2 u -- n ), compare u bytes, n = -1, 0, 1
+        DU u = POP();
+        U8 *q = _blk(POP(), u);
+        U8 *p = q ? _blk(TOS, u) : NULL;
+        int r = p ? memcmp(p, q, u) : 0;
+        TOS = (r > 0) - (r < 0);
+    } break;
+    case 14: case 15: case 16: case 17:       // SUM, AMN, AMX, DOT on cell arrays
+        _array(op - 14);            break;
+    case 18: {                      // CB! ( v a -- ), push v into circular buffer
+        DU a = POP();
+        _ring(POP(), a);
+    } break;
+    }
+}
+///
+///> local variables, frame on the return stack (see N4Asm locals)
+///
+void _frame(U8 v)
+{
+    U8 n = v & LCL_MASK;
+    switch (v & ~LCL_MASK) {
+    case LCL_GET: PUSH(*(vm.rp - n));       break;  // local fetch
+    case LCL_SET: *(vm.rp - n) = POP();     break;  // local store
+    case LCL_ENT:                                   // first local deepest
+        for (U8 i=n; i--; ) RPUSH(SS(i));
+        vm.sp += n;                         break;
+    case LCL_END: vm.rp -= n;               break;  // drop frame
+    }
+}
+///
+///> CAS dispatch, table [EXT, X_JTB|X_CHN, sz, cnt, default(2), ...] (see N4Asm::_add_case)
+/// @return body of the matched OF (selector dropped), or default (selector kept)
+///
+U16 _case(U8 *t)
+{
+    U8  n = t[3];
+    U16 d = GET16(t+4);
+    U16 a = d;
+    U8  *p = t + X_TBL_HDR;
+    if (t[1]==X_JTB) {                              // dense, index into table
+        DU i = (DU)TOS - (DU)GETC(p);
+        if (i < n) a = GET16(p + N4_CELL_SZ + 2*i);
+    }
+    else {                                          // sparse, compare chain
+        for (; n; n--, p += N4_CELL_SZ + 2) {
+            if ((DS)GETC(p)==TOS) { a = GET16(p + N4_CELL_SZ); break; }
+        }
+    }
+    if (a != d) vm.sp++;                            // matched, selector dropped
+    return a;
+}
+///
+///> pending ISR runs as a call from here, within the same dispatch loop (no C recursion)
+/// @return ISR entry, or xt if none pending
+///
+INLINE U16 _isr(U16 xt)
+{
+    U16 ix = N4Intr::isr();
+    if (!ix) return xt;
+    RPUSH(xt);                                      // ISR returns to xt
+    return ix;
+}
+///
+///> DO...LOP loop control, frame [exit, limit, index] on return stack, I reads index,
+///> and CAS dispatch
+/// @return next xt
+///
+INLINE U16 _loop(U8 x, U16 xt)
+{
+#if N4_WIDE_ADR
+    U16 w = GETA(DIC(xt+1));                        // branch following the opcode
+#else
+    U16 w = GET16(DIC(xt)) & ADR_MASK;
+#endif // N4_WIDE_ADR
+    switch (x) {
+    case X_DO: {                                    // DO ( limit start -- )
+        DS i = POP();
+        RPUSH(w);                                   // exit
+        RPUSH(POP());                               // limit
+        RPUSH(i);                                   // index
+    } break;
+    case X_LOOP:                                    // LOP
+    case X_PLOOP: {                                 // +LP ( n -- )
+        DS n = x==X_LOOP ? 1 : POP();
+        DS d = (DS)(*(vm.rp-1) - *(vm.rp-2));       // index - limit
+        DS e = (DS)((DU)d + (DU)n);
+        *(vm.rp-1) += n;
+        if (((d ^ e) & (d ^ n)) < 0) {              // crossed limit-1|limit boundary
+            vm.rp -= 3;
+            break;
+        }
+        return _isr(w);                             // back to loop body, ISR first if pending
+    }
+    case X_LEAVE:                                   // LVE
+        vm.rp -= 3;
+        return (U16)*vm.rp;                         // exit address of frame
+    case X_CAS: return _case(DIC(w));               // CAS ( n -- )
+    case X_IS: {                                    // IS ( xt pfa -- )
+        U16 pfa = POP();
+        N4Asm::is(pfa, POP());
+    } return xt;
+    case X_DOES:                                    // CREated word ( -- a )
+        PUSH(xt + JMP_SZ + 1);                      // data field, after the RET
+        return w;                                   // DO> code, or the RET
+    case X_JTB:
+    case X_CHN: return xt + 1 + *DIC(xt);           // table, skip over
+    }
+    return xt + JMP_SZ;
 }
 ///
 ///> invoke a built-in opcode
@@ -163,12 +571,12 @@ void _invoke(U8 op)
     _X(1,  POP());                  // DRP
     _X(2,  PUSH(TOS));              // DUP
     _X(3,                           // SWP
-        U16 x = SS(1);
+        DS  x = SS(1);
         SS(1) = TOS;
         TOS   = x);
     _X(4,  PUSH(SS(1)));            // OVR
     _X(5,                           // ROT
-        U16 x = SS(2);
+        DS  x = SS(2);
         SS(2) = SS(1);
         SS(1) = TOS;
         TOS   = x);
@@ -188,8 +596,8 @@ void _invoke(U8 op)
     _X(19, TOS = POP()> TOS);       // <
     _X(20, TOS = POP()< TOS);       // >
     _X(21, TOS = POP()!=TOS);       // <>
-    _X(22, U8 *p = DIC(POP()); PUSH(GET16(p)) ); // @
-    _X(23, U8 *p = DIC(POP()); ENC16(p, POP())); // !
+    _X(22, U8 *p = DIC(POP()); PUSH(GETC(p))  ); // @
+    _X(23, U8 *p = DIC(POP()); ENCC(p, POP()) ); // !
     _X(24, U8 *p = DIC(POP()); PUSH((U16)*p)  ); // C@
     _X(25, U8 *p = DIC(POP()); *p = (U8)POP() ); // C!
     _X(26, PUSH((U16)key()));       // KEY
@@ -201,15 +609,15 @@ void _invoke(U8 op)
     _X(32, PUSH(RPOP()));           // R>
     _X(33, PUSH(IDX(N4Asm::here))); // HRE
     _X(34, PUSH(random(POP())));    // RND
-    _X(35, N4Asm::here += POP());   // ALO
+    _X(35, N4Asm::allot(POP()));    // ALO
     _X(36, trc = POP());            // TRC
     _X(37, _clock());               // CLK
     _X(38, _dplus());               // D+
     _X(39, _dminus());              // D-
     _X(40, _dneg());                // DNG
     _X(41, TOS = abs(TOS));         // ABS
-    _X(42, S16 n = POP(); TOS = n>TOS ? n : TOS); // MAX
-    _X(43, S16 n = POP(); TOS = n<TOS ? n : TOS); // MIN
+    _X(42, DS n = POP(); TOS = n>TOS ? n : TOS);  // MAX
+    _X(43, DS n = POP(); TOS = n<TOS ? n : TOS);  // MIN
     _X(44, NanoForth::wait((U32)POP()));          // DLY
     _X(45, PUSH(d_in(POP())));                    // IN
     _X(46, PUSH(a_in(POP())));                    // AIN
@@ -225,23 +633,98 @@ void _invoke(U8 op)
     _X(54, N4Asm::comma(POP()));    // ,    comma, add a 16-bit value onto dictionary
     _X(55, N4Asm::ccomma(POP()));   // C,   C-comma, add a 8-bit value onto dictionary
     _X(56, PUSH(N4Asm::query()));   // '    tick, get parameter field of a word
-    _X(57, _nest(POP()));           // EXE  execute a given parameter field
+    _X(57, call(POP()));            // EXE  execute a given parameter field (interpreter, _nest has its own)
     _X(58, {});                     // DO> handled at upper level
 #endif // N4_DOES_META
-    _X(59, {});                     // available
-    _X(60, {});                     // available
+    _X(59, {});                     // EXT handled at upper level
+    _X(60, {});                     // LCL handled at upper level
     _X(61, PUSH(*(vm.rp - 1)));     // 61, I
     _X(62, RPUSH(POP()));           // 62, FOR
     _X(63, {});                     // 63, LIT handled at upper level
     }
 }
 ///
+///> subroutine call, nx kept on return stack
+/// @return next xt, w or a pending ISR
+///
+INLINE U16 _call(U16 nx, U16 w)
+{
+#if N4_PROF
+    U16 *c = &N4Asm::prof[PROF_IX(w)];
+    if (*c != 0xffff) (*c)++;                       // count call, saturating
+#endif // N4_PROF
+#if N4_AOT
+    FPTR fn = _native(w);
+    if (fn) return _run(fn) ? _isr(nx) : nx;       // native code
+#endif // N4_AOT
+    RPUSH(nx);                                      // keep next instruction on return stack
+    return _isr(w);                                 // jump to subroutine till I_RET, ISR first
+}
+#if N4_EFF
+///
+///> stack effect of code at xt, need<0 when not known (recursive, EXE, API)
+///
+void _eff(U16 xt, EffRec *e)
+{
+    if (!N4Asm::effect(xt, e)) e->need = -1;
+}
+///
+///> check an effect against the stacks before running its code
+/// @return 1: fits, or effect not known; 0: provable underflow or overflow
+///
+U8 _fits(EffRec *e)
+{
+    if (e->need < 0) return 1;                      /// * not known: run as is
+    int n    = (int)(SP0 - vm.sp);                  ///< cells on data stack
+    int room = (int)((U8*)vm.sp - (U8*)vm.rp) / (int)sizeof(DU);
+    if (e->need > n) { show("UDF!\n"); return 0; } /// * short on every path (some may not run)
+    if (e->dmax + e->rmax + 1 > room) { show("OVF!\n"); return 0; }
+    return 1;
+}
+#endif // N4_EFF
+///
+///> check a cached line, with the effect taken when it was compiled
+///
+U8 _fits(LnRec *r)
+{
+#if N4_EFF
+    return _fits(&r->e);
+#else
+    return 1;
+#endif // N4_EFF
+}
+///
+///> check a word called from console, its effect walked once until here moves
+///
+U8 _fits(U16 xt)
+{
+#if N4_EFF
+    WfRec *r = _wfc;
+    for (U8 i=0; i<_wfn; i++, r++) if (r->xt==xt) return _fits(&r->e);
+    r = &_wfc[_wfn < N4_LNC_SZ ? _wfn++ : xt % N4_LNC_SZ];
+    r->xt = xt;
+    _eff(xt, &r->e);
+    return _fits(&r->e);
+#else
+    return 1;
+#endif // N4_EFF
+}
+///
 ///> opcode execution unit i.e. inner interpreter
 ///
 void _nest(U16 xt)
 {
+    U16 rd = (U16)(vm.rp - rp0);                          // frame base, kept as depth (, ALO move rp0)
     RPUSH(LFA_END);                                       // enter function call
     while (xt != LFA_END) {                               ///> walk through instruction sequences
+#if N4_STK_CHECK
+        if (_rovf) {                                      // a push ran into data stack
+            show("OVF!\n");
+            _rovf = 0;
+            vm.rp = rp0 + rd;                             // unwind this call frame
+            return;
+        }
+#endif // N4_STK_CHECK
         U8 op = *DIC(xt);                                 // fetch instruction
 
 #if    TRC_LEVEL > 0
@@ -249,22 +732,22 @@ void _nest(U16 xt)
 #endif // TRC_LEVEL
 
         if ((op & CTL_BITS)==JMP_OPS) {                   ///> determine control bits
+#if N4_WIDE_ADR
+            U16 w = GETA(DIC(xt+1));                      // 16-bit target address
+#else
             U16 w = (((U16)op<<8) | *DIC(xt+1)) & ADR_MASK;  // target address
+#endif // N4_WIDE_ADR
             switch (op & JMP_MASK) {                      // get branch opcode
-            case OP_CALL:                                 // 0xc0 subroutine call
-                serv_isr();                               // loop-around every 256 ops
-                RPUSH(xt+2);                              // keep next instruction on return stack
-                xt = w;                                   // jump to subroutine till I_RET
-                break;
-            case OP_CDJ: xt = POP() ? xt+2 : w; break;    // 0xd0 conditional jump
+            case OP_CALL: xt = _call(xt+JMP_SZ, w); break; // 0xc0 subroutine call
+            case OP_CDJ: xt = POP() ? xt+JMP_SZ : w; break; // 0xd0 conditional jump
             case OP_UDJ: xt = w;                break;    // 0xe0 unconditional jump
             case OP_NXT:                                  // 0xf0 FOR...NXT
                 if (!--(*(vm.rp-1))) {                    // decrement counter *(rp-1)
-                    xt += 2;                              // break loop
+                    xt += JMP_SZ;                         // break loop
                     RPOP();                               // pop off loop index
                 }
                 else xt = w;                              // loop back
-                serv_isr();                               // loop-around every 256 ops
+                xt = _isr(xt);                            // pending ISR runs as a call
                 break;
             }
         }
@@ -273,20 +756,44 @@ void _nest(U16 xt)
             op &= PRM_MASK;                               // get primitive opcode
             switch(op) {
             case I_RET: xt = RPOP();     break;           // POP return address
-            case I_LIT: {                                 // 3-byte literal
-                U16 w = GET16(DIC(xt));                   // fetch the 16-bit literal
+            case I_LIT: {                                 // cell-wide literal
+                DU w = GETL(DIC(xt));                     // fetch the literal
                 PUSH(w);                                  // put the value on TOS
-                xt += 2;                                  // skip over the 16-bit literal
+                xt += N4_CELL_SZ;                         // skip over the literal
             }                            break;
             case I_DQ:                                    // handle ." (len,byte,byte,...)
                 d_str(DIC(xt));                           // display the string
                 xt += *DIC(xt) + 1;      break;           // skip over the string
+            case I_EXT: {                                 // extended word, index follows
+                U8 x = *DIC(xt++);
+                if (x & X_DO) xt = _loop(x, xt);          // loop control
+                else _extend(x);
+            }                            break;
+            case I_LCL: _frame(*DIC(xt++));  break;      // local variable, operand follows
+            case I_EXE: {                                 // EXE, call without C recursion
+#if N4_AOT
+                FPTR fn = _native(TOS);
+                if (fn) { vm.sp++; _run(fn); break; }     // or native code
+#endif // N4_AOT
+                RPUSH(xt);
+                xt = POP();
+            }                            break;
             case I_DO:                                    // metaprogrammer
                 N4Asm::does(xt);                          // jump to definding word DO> section
-                xt = LFA_END;            break;
+                xt = RPOP();             break;           // and return from the defining word
             default: _invoke(op);                         // handle other opcodes
             }
         }
+#if N4_DENSE
+        else if (op >= OP_HOT) {                          ///> 1-byte call through hot-call table
+            xt = _call(xt+1, N4Asm::hot[op - OP_HOT]);
+        }
+        else if (op >= OP_SLIT) {                         ///> short literal, 0..255 or -256..-1
+            DS v = *DIC(xt+1);
+            PUSH(op==OP_SLIT ? v : v - 256);
+            xt += 2;
+        }
+#endif // N4_DENSE
         else {                                            ///> handle number (1-byte literal)
             xt++;
             PUSH(op);                                     // put the 7-bit literal on TOS
@@ -294,11 +801,36 @@ void _nest(U16 xt)
     }
 }
 ///
+///> run colon word at xt, native code when translated
+///
+void call(U16 xt)
+{
+#if N4_AOT
+    FPTR fn = _native(xt);
+    if (fn) { _run(fn); return; }
+#endif // N4_AOT
+    _nest(xt);
+}
+#if N4_AOT
+///
+///> native code interface
+///
+void native(const AotRec *t, U16 n, U16 sum)
+{
+    _aot  = t;
+    _aotm = n;
+    _aots = sum;
+    if (N4Asm::here) _aot_check();       /// * or at setup, when called before it
+}
+void invoke(U8 op) { _invoke(op); }
+void nest(U16 xt)  { _nest(xt);   }
+#endif // N4_AOT
+///
 ///> constructor and initializer
 ///
-void setup(const char *code, Stream &io, U8 ucase)
+void setup(const char *code, Stream &io, U8 ucase, U16 sz)
 {
-    init_mem();
+    init_mem(sz);
     memstat();               ///< display VM system info
 
     set_pre(code);           /// * install embedded Forth code
@@ -309,34 +841,192 @@ void setup(const char *code, Stream &io, U8 ucase)
     _init();                 /// * init VM
 }
 ///
+///> boot again, i.e. once a persistence backend is plugged in after setup
+///
+void restart() { _init(); }
+///
 ///> VM proxy functions
 ///
 void push(int v) { PUSH(v);      }
 int  pop()       { return POP(); }
 ///
-///> virtual machine interrupt service routine
+///> VM snapshot (hibernate/resume)
+/// @brief
+///    header : sig(2) last(2) here(2) rs(2) ss(2) mode(1) 0(1)<br/>
+///    body   : dic[0..here-1], return stack (rs bytes), data stack (ss bytes), IsrRec<br/>
+///    return stack is restored right above dictionary, data stack at top of region<br/>
+///    stacks and interrupt record are kept in native byte order, i.e. a snapshot<br/>
+///    resumes only on the target it was taken from
+///
+constexpr U16 SNAP_HDR = 12;
+U8 hibernate()
+{
+    U8  hdr[SNAP_HDR];
+    U16 here_i = IDX(N4Asm::here);
+    U16 rs     = (U16)((U8*)vm.rp - (U8*)rp0);
+    U16 ss     = (U16)((U8*)SP0 - (U8*)vm.sp);
+    U16 sz     = SNAP_HDR + here_i + rs + ss + sizeof(IsrRec);
+    if (sz > N4Asm::rom_size() || vm.sp < (DS*)vm.rp) return 0;
+
+    U8 *p = hdr;
+    ENC16(p, N4_SNAP);
+    ENC16(p, IDX(N4Asm::last));
+    ENC16(p, here_i);
+    ENC16(p, rs);
+    ENC16(p, ss);
+    ENC8(p, get_mode());
+    ENC8(p, 0);
+
+    U16 i = 0;
+    N4Asm::rom_write(i, hdr, SNAP_HDR);                 i += SNAP_HDR;
+    N4Asm::rom_write(i, dic, here_i);                   i += here_i;
+    N4Asm::rom_write(i, (U8*)rp0, rs);                  i += rs;
+    N4Asm::rom_write(i, (U8*)vm.sp, ss);                i += ss;
+    N4Asm::rom_write(i, (U8*)&N4Intr::ir, sizeof(IsrRec));
+
+    return 1;
+}
+U8 resume()
+{
+    U8 hdr[SNAP_HDR];
+    N4Asm::rom_read(0, hdr, SNAP_HDR);
+    if (GET16(hdr) != N4_SNAP) return 0;                /// * not a snapshot
+
+    U16 last_i = GET16(hdr+2);
+    U16 here_i = GET16(hdr+4);
+    U16 rs     = GET16(hdr+6);
+    U16 ss     = GET16(hdr+8);
+    U16 rp0_i  = (here_i + sizeof(DU)-1) & ~(sizeof(DU)-1);  /// * cell aligned boundary
+    if ((U32)rp0_i + rs + ss + N4_STK_MIN > msz) return 0;  /// * not fit in this region
+
+    N4Intr::reset();                                    /// * quiet ISRs while restoring
+    N4Asm::here = DIC(here_i);
+    N4Asm::last = DIC(last_i);
+    _lnc_clear();
+    rp0         = (DU*)DIC(rp0_i);
+    vm.rp       = (DU*)(DIC(rp0_i) + rs);
+    vm.sp       = (DS*)((U8*)SP0 - ss);
+
+    U16 i = SNAP_HDR;
+    N4Asm::rom_read(i, dic, here_i);                    i += here_i;
+    N4Asm::rom_read(i, (U8*)rp0, rs);                   i += rs;
+    N4Asm::rom_read(i, (U8*)vm.sp, ss);                 i += ss;
+    N4Asm::rom_read(i, (U8*)&N4Intr::ir, sizeof(IsrRec));
+    N4Asm::hot_scan();                                  /// * hot-call slots from name fields
+    set_mode(hdr[10]);
+    N4Intr::restore();                                  /// * re-arm timer and pin change
+
+    return 1;
+}
+///
+///> virtual machine interrupt service routine (idle and DLY, _nest serves ISRs itself)
 ///
 void serv_isr() {
     U16 xt = N4Intr::isr();
     if (xt) _nest(xt);
 }
+#if N4_LINE_RUN
 ///
-///> virtual machine execute single step (outer interpreter)
+///> run the line just accepted as compiled code (cached for repeated lines)
 /// @return
-///  1: more token(s) in input buffer<br/>
-///  0: buffer empty (yield control back to hardware)
+///    1: line executed<br/>
+///    0: line needs the token-by-token interpreter
+///
+U8 _line()
+{
+    U8  *src = get_line();
+    if (!src) return 0;                          /// * tokens already taken from this line
+
+    U16 h  = 5381;                               ///> djb2 hash, length with terminator
+    U16 sz = 0;
+    do { h = (h << 5) + h + src[sz]; } while (src[sz++]);
+
+    for (U8 i=0; i<_lnn; i++) {                  ///> cache hit, run it
+        LnRec *r = &_lnc[i];
+        if (r->h==h && !memcmp(DIC(r->src), src, sz)) {
+            clear_tib();
+            if (_fits(r)) _nest(r->xt);
+            return 1;
+        }
+    }
+    U16 here_i = IDX(N4Asm::here);               ///> scratch takes up to half of free space
+    U16 half   = (IDX(vm.sp) - here_i) >> 1;
+    U16 need   = sz + ((sz*OPS_X2)>>1) + 1;      /// * text + code + RET
+    if (_lnt - here_i + need > half || !mem_move(DIC(_lnt + need))) {
+        _lnn = _lnv = 0;                         /// * scratch full, start over
+        _lnt = here_i;
+        if (need > half || !mem_move(DIC(_lnt + need))) return 0;
+    }
+
+    U8 *h0  = N4Asm::here;
+    U16 xt  = _lnt + sz;
+    memcpy(DIC(_lnt), src, sz);                  /// * keep line text to verify hits
+    N4Asm::here = DIC(xt);
+
+    U8 t = trc;                                  /// * no token echo, it may be rewound
+    trc  = 0;
+    U8 ok = N4Asm::line(vm.rp);
+    trc  = t;
+    U16 top = IDX(N4Asm::here);
+    N4Asm::here = h0;
+    if (!ok) {                                   ///> leave it to the interpreter
+        _park();
+        rewind(src);
+        return 0;
+    }
+    LnRec *r = &_lnc[_lnn < N4_LNC_SZ ? _lnn++ : _lnv++ % N4_LNC_SZ];
+    r->h   = h;
+    r->src = _lnt;
+    r->xt  = xt;
+#if N4_EFF
+    _eff(xt, &r->e);                             /// * walked once, hits reuse it
+#endif // N4_EFF
+    _lnt   = top;
+    _park();                                     /// * return stack above the new line
+
+    if (_fits(r)) _nest(r->xt);                  ///> run compiled line
+    return 1;
+}
+#endif // N4_LINE_RUN
+///
+///> virtual machine execute single step (outer interpreter)
+///  * never waits for console input, an incomplete line returns immediately
 ///
 void outer()
 {
-    ok();                                        ///> console ok prompt if tib is empty
+    if (!N4Asm::cmode) {
+        _park();                                 ///> return stack empty, settle the boundary
+        ok();                                    ///> console ok prompt (once) if tib is empty
+    }
+    if (!accept()) return;                       ///> line incomplete, return to user tasks
+#if N4_LINE_RUN
+    if (!N4Asm::cmode && _line()) return;        ///> whole line run as compiled code
+#endif // N4_LINE_RUN
     U8  *tkn = get_token();                      ///> get a token from console
-    U16 tmp;
+    if (!tkn) return;                            ///> input ended
+    if (N4Asm::cmode) {                          ///> inside a colon definition
+        N4Asm::compile(tkn);
+#if N4_AOT
+        if (!N4Asm::cmode) _aot_check();         ///> word closed, it may complete the code
+#endif // N4_AOT
+        return;
+    }
+    DU  tmp;
     switch (N4Asm::parse(tkn, &tmp, 1)) {        ///> parse action from token (keep opcode in tmp)
-    case TKN_IMM: _immediate(tmp);      break;   ///>> immediate words,
-    case TKN_WRD: _nest(tmp + 2 + 3);   break;   ///>> execute colon word (user defined)
+    case TKN_IMM:                                ///>> immediate words,
+        _immediate(tmp);
+        _lnc_clear();                            ///>> which may change dictionary
+#if N4_AOT
+        _aot_check();                            ///>> and code translated from it
+#endif // N4_AOT
+        if (!N4Asm::cmode) _park();              ///>> keep ISRs off the new words
+        break;
+    case TKN_WRD:                                ///>> execute colon word (user defined)
+        if (_fits(tmp + 2 + 3)) call(tmp + 2 + 3);
+        break;
     case TKN_PRM: _invoke((U8)tmp);     break;   ///>> execute primitive built-in word,
     case TKN_NUM: PUSH(tmp);            break;   ///>> push a number (literal) to stack top,
-    case TKN_EXT:                                ///>> extended words, not implemented yet
+    case TKN_EXT: _extend((U8)tmp);     break;   ///>> execute extended word
     default:                                     ///>> or, error (unknown action)
         show("?\n");
     }
@@ -6,6 +6,15 @@
 #ifndef __SRC_N4_VM_H
 #define __SRC_N4_VM_H
 #include "n4.h"
+#if N4_AOT
+///
+/// word translated ahead of time, see n4 -c
+///
+typedef struct {
+    U16  xt;                  ///< parameter field of the word
+    FPTR fn;                  ///< native code
+} AotRec;
+#endif // N4_AOT
 ///
 /// nanoForth Virtual Machine class
 ///
@@ -18,9 +27,27 @@ namespace N4VM
     void setup(
     	const char *code,     ///< preload Forth code
         Stream &io,           ///< IO stream
-        U8 ucase              ///< case sensitiveness
+        U8 ucase,             ///< case sensitiveness
+        U16 sz                ///< dictionary+stacks region size, 0: all available
         );
     void outer();             ///< outer-interpreter
+    void restart();           ///< reset VM and boot from ROM again (resume, or autorun word)
     void serv_isr();          ///< interrupt service routine
+    U8   hibernate();         ///< save whole VM state into EEPROM, 1: ok
+    U8   resume();            ///< restore VM state from EEPROM snapshot, 1: ok
+    void call(U16 xt);        ///< run colon word at xt, native code when translated
+#if N4_AOT
+    ///
+    ///@name Native Code Interface (used by the code n4 -c generates)
+    ///@{
+    void native(              ///< register words translated ahead of time
+        const AotRec *t,      ///< words, ascending xt
+        U16 n,                ///< number of words
+        U16 sum               ///< N4Asm::code_sum of their code when translated
+        );
+    void invoke(U8 op);       ///< run a primitive
+    void nest(U16 xt);        ///< run bytecode at xt, a word left untranslated
+    ///@}
+#endif // N4_AOT
 };  // namespace N4VM
 #endif //__SRC_N4_VM_H
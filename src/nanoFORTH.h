@@ -5,10 +5,18 @@
 #ifndef __SRC_NANOFORTH_H
 #define __SRC_NANOFORTH_H
 
-extern void n4_setup(const char *code=0, Stream &io=Serial, int ucase=0);
+extern void n4_setup(const char *code=0, Stream &io=Serial, int ucase=0, int msz=0);
 extern void n4_api(int i, void (*fp)());
 extern void n4_push(int v);
 extern int  n4_pop();
+extern int  n4_hibernate();     ///< snapshot VM state into EEPROM, 1: ok
+extern int  n4_resume();        ///< restore VM state from EEPROM snapshot, 1: ok
+extern void n4_rom(             ///< plug in a persistence backend (i.e. FRAM, SPI flash), NULLs for EEPROM
+    uint16_t (*sz)(),                                   ///< capacity in bytes
+    void (*rd)(uint16_t idx, uint8_t *p, uint16_t n),   ///< bulk read
+    void (*wr)(uint16_t idx, uint8_t *p, uint16_t n),   ///< bulk write
+    int boot=0);                ///< 1: after setup, a changed backend boots the VM again (live dictionary and stacks lost)
 extern void n4_run();
+extern void n4_native();        ///< register words translated by n4 -c, defined in the file it writes
 
 #endif // __SRC_NANOFORTH_H
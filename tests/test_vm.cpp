@@ -0,0 +1,327 @@
+///
+/// Unit Test - NanoForth VM (regression scripts fed through an in-memory console)
+///
+///> g++ -std=c++14 -c -Dmain=n4_main ../src/n4.cpp && g++ -std=c++14 -Wall n4.o ../src/n4_*.cpp ../src/mock*.cpp test_vm.cpp && a.out
+///> add -DN4_CELL_SZ=4 to both for the 32-bit cell cases, -DN4_DENSE=1 for dense code
+///
+#define  CATCH_CONFIG_MAIN
+#include "../../../catch2/catch.hpp"
+#include "../src/n4_core.h"
+#include "../src/n4_asm.h"
+#include "../src/nanoFORTH.h"
+#include <string>
+
+NanoForth n4;
+///
+/// boot a fresh VM, feed it the script and return what it printed
+///
+std::string run(const std::string &src)
+{
+    static char out[0x2000];
+    memset(out, 0, sizeof(out));
+    FILE *fo = fmemopen(out, sizeof(out) - 1, "w");
+    std::string s = "0 TRC DRP\n" + src;       // tracing off, output kept short
+    MemStream in(s.data(), s.size(), fo);
+
+    n4.setup(NULL, in, 0, 0);
+    while (!in.eof() || N4Core::pending()) n4.exec();
+    N4Core::flush();
+    fclose(fo);
+
+    return std::string(out);
+}
+#define HAS(o, s)  ((o).find(s) != std::string::npos)
+
+TEST_CASE("UPL")
+{
+    SECTION("an oversized frame is drained, not run as source") {
+        std::string f(0x50, ' ');
+        for (int i=0; i < 0x50; i+=8) f.replace(i, 8, "4 5 + . ");
+        std::string o = run("UPL\n\x02\x50" + f + "\x01\x01" + std::string(1, '\0') + "1 2 + .\n");
+        REQUIRE(HAS(o, "CRC!"));
+        REQUIRE(!HAS(o, "9 "));
+        REQUIRE(HAS(o, "3 "));
+    }
+}
+
+TEST_CASE("console input")
+{
+    SECTION("lines longer than tib are dropped whole") {
+        std::string o = run("9 . " + std::string(200, ' ') + "1 .\n2 .\n");
+        REQUIRE(HAS(o, "TIB!"));
+        REQUIRE(!HAS(o, "9 "));
+        REQUIRE(HAS(o, "2 "));
+    }
+    SECTION("a line filling tib exactly runs") {
+        std::string s = "7 ." + std::string(N4_TIB_SZ - 2 - 3, ' ') + "\n";
+        REQUIRE(HAS(run(s), "7 "));
+    }
+    SECTION("input ending inside a word ends the session") {
+        REQUIRE(HAS(run("1 2 + . KEY"), "3 "));
+        REQUIRE(HAS(run("1 2 + . :"), "3 "));
+        REQUIRE(HAS(run("1 2 + . VAR"), "3 "));
+        REQUIRE(HAS(run("1 2 + . '"), "?!"));
+        REQUIRE(HAS(run("1 2 + . : X .\" ab"), "3 "));
+    }
+}
+
+TEST_CASE("line run")
+{
+    SECTION("control structures run outside a definition") {
+        REQUIRE(HAS(run("0 4 FOR I + NXT .\n"), "10 "));
+    }
+    SECTION("a repeated line runs from the cache") {
+        REQUIRE(HAS(run("VAR v\nv @ 1 + v !\nv @ 1 + v !\nv @ .\n"), "2 "));
+    }
+    SECTION("words growing the dictionary leave the line running") {
+        REQUIRE(HAS(run(": Z 1 , 2 , 3 , ;\nZ Z 1 2 + .\n"), "3 "));
+    }
+#if N4_EFF
+    SECTION("a cached line is checked against the stack on every run") {
+        std::string o = run(": U + ;\n1 2\nU .\nU .\n");
+        REQUIRE(HAS(o, "3 "));
+        REQUIRE(HAS(o, "UDF!"));
+    }
+#endif // N4_EFF
+}
+
+TEST_CASE("return stack overflow")
+{
+    SECTION("runaway pushes report OVF! and unwind") {
+        const char *src[] = {
+            ": B BGN 1 >R 0 UTL ;\nB\n1 2 + .\n",
+            ": D 5 0 DO D LOP ;\nD\n1 2 + .\n",
+            ": E { a } a a E ;\n3 E\n1 2 + .\n",
+            "VAR v\n: A v @ EXE ;\n' A v !\nA\n1 2 + .\n"
+        };
+        for (const char *s : src) {
+            std::string o = run(s);
+            REQUIRE(HAS(o, "OVF!"));
+            REQUIRE(HAS(o, "3 "));
+        }
+    }
+}
+
+TEST_CASE("mixed precision")
+{
+#if N4_CELL_SZ==4
+    const std::string mx = "2147483647 ", mn = "-2147483648 ";
+#else
+    const std::string mx = "32767 ", mn = "-32768 ";
+#endif // N4_CELL_SZ==4
+    SECTION("products and quotients through a double") {
+        REQUIRE(HAS(run("6 7 4 */ .\n"),     "10 "));
+        REQUIRE(HAS(run("6 7 4 */M . .\n"),  "10 2 "));
+        REQUIRE(HAS(run("7 0 5 UM/ . .\n"),  "1 2 "));
+        REQUIRE(HAS(run("-3 4 M* . .\n"),    "-1 -12 "));
+    }
+    SECTION("a 0 divisor saturates instead of trapping") {
+        REQUIRE(HAS(run("1 0 0 UM/ . .\n"),  "-1 0 "));
+        REQUIRE(HAS(run("5 7 0 */ .\n"),     mx));
+        REQUIRE(HAS(run("-5 7 0 */ .\n"),    mn));
+        REQUIRE(HAS(run("5 7 0 */M . .\n"),  mx + "0 "));
+    }
+}
+
+TEST_CASE("fixed point")
+{
+#if N4_CELL_SZ==4                              // Q16.16 and Q1.31
+    const std::string mx = "2147483647 ";
+    const char *q[] = { "$18000 $20000 Q* .\n", "196608 ", "$30000 $20000 Q/ .\n", "98304 ",
+                        "$40000000 $40000000 F* .\n", "536870912 ", "0 100 $40000000 LRP .\n", "50 " };
+#else
+    const std::string mx = "32767 ";
+    const char *q[] = { "$180 $200 Q* .\n", "768 ", "$300 $200 Q/ .\n", "384 ",
+                        "$4000 $4000 F* .\n", "8192 ", "0 100 $4000 LRP .\n", "50 " };
+#endif // N4_CELL_SZ==4
+    SECTION("Q8.8 and Q1.15 products and quotients") {
+        for (int i=0; i < 8; i+=2) REQUIRE(HAS(run(q[i]), q[i+1]));
+    }
+    SECTION("saturation") {
+        REQUIRE(HAS(run("1 0 Q/ .\n"),         mx));
+        REQUIRE(HAS(run(mx + "1 S+ .\n"),      mx));
+    }
+}
+
+TEST_CASE("block and array words")
+{
+    const std::string c = std::to_string(N4_CELL_SZ) + " ";   // cell size in bytes
+    const std::string a = "CRE A 1 , 2 , 3 ,\n";
+    SECTION("results") {
+        REQUIRE(HAS(run(a + "A 3 SUM . .\n"),              "0 6 "));
+        REQUIRE(HAS(run(a + "A A " + c + "+ 2 DOT . .\n"), "0 8 "));
+        REQUIRE(HAS(run(a + "A 3 AMX . A 3 AMN .\n"),      "3 1 "));
+        REQUIRE(HAS(run(a + "CRE S 8 ALO\nA S 8 MOV S " + c + "+ @ .\n"), "2 "));
+        REQUIRE(HAS(run(a + "CRE S 8 ALO\nA S 8 MOV A S 8 CMP .\n"),     "0 "));
+    }
+    SECTION("a circular buffer wraps around") {
+        std::string o = run("CRE C 2 , 0 , 0 , 0 ,\n7 C CB! 8 C CB! 9 C CB!\n"
+                            "C " + c + "+ @ . C " + c + "2 * + @ . C " + c + "3 * + @ .\n");
+        REQUIRE(HAS(o, "1 9 8 "));
+    }
+    SECTION("a huge count does not wrap past the bounds check") {
+        REQUIRE(HAS(run(a + "A 32769 SUM . .\n"), "ADR!"));
+        REQUIRE(HAS(run(a + "A -1 AMX .\n"),      "ADR!"));
+        std::string o = run("CRE B 32767 , 100 , 0 ,\n7 B CB!\nB " + c + "+ @ .\n");
+        REQUIRE(HAS(o, "ADR!"));
+        REQUIRE(HAS(o, "100 "));
+    }
+}
+
+TEST_CASE("locals")
+{
+    SECTION("taken from the stack, first name deepest") {
+        REQUIRE(HAS(run(": W { a b } a . b . ;\n1 2 W\n"), "1 2 "));
+    }
+    SECTION("TO stores, each call has its own frame") {
+        REQUIRE(HAS(run(": T { a } 5 TO a a . ;\n1 T\n"), "5 "));
+        REQUIRE(HAS(run(": F { n } n 1 > IF n 1 - F n * ELS 1 THN ;\n5 F .\n"), "120 "));
+    }
+}
+
+TEST_CASE("DO loops")
+{
+    SECTION("LOP and +LP") {
+        REQUIRE(HAS(run(": P 3 0 DO I . LOP ;\nP\n"),        "0 1 2 "));
+        REQUIRE(HAS(run(": P 10 0 DO I . 3 +LP ;\nP\n"),     "0 3 6 9 "));
+        REQUIRE(HAS(run(": P 0 10 DO I . -3 +LP ;\nP\n"),    "10 7 4 1 "));
+    }
+    SECTION("LVE leaves the innermost DO only") {
+        std::string o = run(": L 3 0 DO 10 0 DO I 2 = IF LVE THN I . LOP I . LOP ;\nL\n");
+        REQUIRE(HAS(o, "0 1 0 0 1 1 0 1 2 "));
+    }
+    SECTION("LVE outside a DO frame is refused") {
+        REQUIRE(HAS(run(": L LVE ;\n"),                        "??"));
+        REQUIRE(HAS(run(": L 5 0 DO 3 FOR LVE NXT LOP ;\n"),   "??"));
+        REQUIRE(HAS(run(": L 5 0 DO 1 >R LVE R> DRP LOP ;\n"), "??"));
+    }
+}
+
+TEST_CASE("CAS")
+{
+    SECTION("dense values dispatch through a jump table, sparse ones a chain") {
+        REQUIRE(HAS(run(": Q CAS 1 OF 10 EOF 2 OF 20 EOF 99 ECS ;\n1 Q . 2 Q . 3 Q .\n"),  "10 20 3 "));
+        REQUIRE(HAS(run(": Q CAS 1 OF 10 EOF 900 OF 20 EOF ECS ;\n900 Q . 1 Q . 5 Q 7 .\n"), "20 10 7 "));
+    }
+    SECTION("misplaced OF, EOF or ECS are refused") {
+        REQUIRE(HAS(run(": Q CAS 1 OF 10 EOF EOF ECS ;\n"), "??"));
+        REQUIRE(HAS(run(": Q CAS 1 OF 10 ECS ;\n"),         "??"));
+        REQUIRE(HAS(run(": Q 1 OF 10 EOF ;\n"),             "??"));
+        REQUIRE(HAS(run(": Q CAS 1 OF 10 EOF ;\n"),         "??"));
+    }
+}
+
+TEST_CASE("DEF and IS")
+{
+    SECTION("IS points a deferred word, at the prompt or compiled") {
+        REQUIRE(HAS(run("DEF D\n: A 1 . ;\n: B 2 . ;\n' A IS D\nD\n"),            "1 "));
+        REQUIRE(HAS(run("DEF D\n: B 2 . ;\n: S ' B IS D ;\nS D\n"),              "2 "));
+    }
+    SECTION("IS on a word not made by DEF is refused") {
+        REQUIRE(HAS(run(": A 1 ;\n: B 2 ;\n' A IS B\n"), "IS!"));
+    }
+    SECTION("WRD lists IS once") {
+        std::string o = run("WRD\n");
+        size_t i = o.find(" IS ");
+        REQUIRE(i != std::string::npos);
+        REQUIRE(o.find(" IS ", i + 1) == std::string::npos);
+    }
+}
+
+#if N4_DENSE
+TEST_CASE("dense code")
+{
+    SECTION("short literals take 2 bytes, both signs") {
+        REQUIRE(HAS(run("HRE : L 200 ; HRE SWP - .\n"),  "8 "));
+        REQUIRE(HAS(run("HRE : M -100 ; HRE SWP - .\n"), "8 "));
+        REQUIRE(HAS(run(": L 200 ;\n: M -100 ;\nL M + .\n"), "100 "));
+    }
+}
+#endif // N4_DENSE
+
+#if N4_WCT
+TEST_CASE("WCT")
+{
+    SECTION("bounded loops give a worst case, others ?") {
+        REQUIRE(HAS(run(": A 5 FOR 1 DRP NXT ;\nWCT A\n"), " cycles"));
+        REQUIRE(HAS(run(": B BGN 1 UTL ;\nWCT B\n"),       "..? cycles"));
+    }
+    SECTION("TMI warns when a handler may outrun its period") {
+        REQUIRE(HAS(run(": L 5000 FOR 1 2 + DRP NXT ;\n1 0 TMI L\n"), "WCT!"));
+        REQUIRE(!HAS(run(": S 1 DRP ;\n1 1 TMI S\n"),                   "WCT!"));
+    }
+}
+
+#endif // N4_WCT
+#if N4_OPT
+TEST_CASE("OPT")
+{
+    const std::string src = ": Y 1 2 + ;\n: Z 5 ;\n: X Y ;\n: G 50 FOR X DRP NXT ;\nG\nOPT\n";
+    SECTION("rewritten words give the same results") {
+        std::string o = run(src + "X .\n");
+        REQUIRE(HAS(o, " rewritten"));
+        REQUIRE(HAS(o, "3 "));
+    }
+    SECTION("a rewritten word does not read as a DEF word") {
+        REQUIRE(HAS(run(src + "' Z IS X\n"), "IS!"));
+    }
+}
+
+#endif // N4_OPT
+#if N4_CELL_SZ==4
+TEST_CASE("32-bit cells")
+{
+    SECTION("stack words keep all 32 bits") {
+        REQUIRE(HAS(run("70000 1 SWP . .\n"),     "70000 1 "));
+        REQUIRE(HAS(run("70000 1 2 ROT . . .\n"), "70000 2 1 "));
+        REQUIRE(HAS(run("70000 1 OVR . . .\n"),   "70000 1 70000 "));
+        REQUIRE(HAS(run("70000 DUP + .\n"),       "140000 "));
+        REQUIRE(HAS(run("70000 >R R> .\n"),       "70000 "));
+    }
+    SECTION("cells in the dictionary and in compiled words") {
+        REQUIRE(HAS(run("VAR v\n70000 v ! v @ .\n"), "70000 "));
+        REQUIRE(HAS(run(": X 70000 1 SWP ;\nX . .\n"), "70000 1 "));
+    }
+}
+#endif // N4_CELL_SZ==4
+
+static U8  fram[0x400];
+static U16 f_sz() { return sizeof(fram); }
+static void f_rd(U16 i, U8 *p, U16 n) { memcpy(p, fram + i, n); }
+static void f_wr(U16 i, U8 *p, U16 n) { memcpy(fram + i, p, n); }
+///
+/// what the VM prints while fn runs (after setup, no console input)
+///
+template<typename F>
+std::string during(F fn)
+{
+    static char out[0x400];
+    memset(out, 0, sizeof(out));
+    FILE *fo = fmemopen(out, sizeof(out) - 1, "w");
+    MemStream in("", 0, fo);
+    n4.setup(NULL, in, 0, 0);
+    fn();
+    N4Core::flush();
+    fclose(fo);
+    return std::string(out);
+}
+
+TEST_CASE("n4_rom")
+{
+    n4_rom(f_sz, f_rd, f_wr);
+    run(": HI .\" booted\" CR ;\nSEX\n");
+    n4_rom(NULL, NULL, NULL);
+
+    SECTION("a backend plugged in after setup boots when asked to") {
+        REQUIRE(HAS(during([]{ n4_rom(f_sz, f_rd, f_wr, 1); }), "booted"));
+    }
+    SECTION("the live VM is kept otherwise") {
+        REQUIRE(!HAS(during([]{ n4_rom(f_sz, f_rd, f_wr); }), "booted"));
+        n4_rom(NULL, NULL, NULL);
+        REQUIRE(!HAS(during([]{ n4_rom(NULL, NULL, NULL, 1); }), "booted"));
+    }
+    SECTION("the same backend again does not boot") {
+        REQUIRE(!HAS(during([]{ n4_rom(f_sz, f_rd, f_wr); n4_rom(f_sz, f_rd, f_wr, 1); }), "booted"));
+    }
+    n4_rom(NULL, NULL, NULL);
+}